@@ -0,0 +1,184 @@
+/*****************************************
+** File:    hashtable_batch.h
+** Project: CSCE 221 Lab 6 Spring 2022
+** Author:  Joshua Hillis
+** Date:    04/12/2022
+** Section: 512
+** E-mail:  joshuahillis292002@tamu.edu
+**
+** This is the header file for the batch hashing kernels used by the open addressing table's
+** insert_many and contains_many. A kernel turns an array of keys into their home cells
+** (homeIndex of their hash). 32 and 64 bit integer keys hashed with std::hash (the identity) or
+** SeededHash get an AVX2 kernel that runs the key hash, the mix and the scaling on 4 keys per
+** step, picked at runtime when the CPU supports it. Everything else goes through the scalar kernel.
+**
+***********************************************/
+
+#ifndef HASHTABLE_BATCH_H
+#define HASHTABLE_BATCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+#include "hashtable_hash.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define HASHTABLE_HAVE_AVX2_KERNEL 1
+#include <immintrin.h>
+#endif
+
+//-------------------------------------------------------
+// Name: vectorHashKind
+// Which hash the AVX2 kernel has to reproduce for a key/hasher pair: 1 for std::hash on a 32 or
+// 64 bit integer, which both libstdc++ and libc++ implement as the identity, 2 for SeededHash on
+// one, and 0 when the kernel doesn't apply.
+//---------------------------------------------------------
+template<class Key, class Hash>
+constexpr int vectorHashKind() {
+    if constexpr (!std::is_integral_v<Key> || std::is_same_v<Key, bool> || (sizeof(Key) != 4 && sizeof(Key) != 8)) {
+        return 0;
+    } else if constexpr (std::is_same_v<Hash, SeededHash<Key>>) {
+        return 2;
+#if defined(__GLIBCXX__) || defined(_LIBCPP_VERSION)
+    } else if constexpr (std::is_same_v<Hash, std::hash<Key>>) {
+        return 1;
+#endif
+    } else {
+        return 0;
+    }
+}
+
+//-------------------------------------------------------
+// Name: homeCellsScalar
+// Works out the home cell of count keys one at a time, for any key and hasher
+//---------------------------------------------------------
+template<class Key, class Hash>
+void homeCellsScalar(const Hash &hasher, const Key *keys, size_t count, size_t cellCount, size_t *homes) {
+    for (size_t i = 0; i < count; i++) {
+        homes[i] = homeIndex(hasher(keys[i]), cellCount);
+    }
+}
+
+#ifdef HASHTABLE_HAVE_AVX2_KERNEL
+//-------------------------------------------------------
+// Name: multiply64
+// The low 64 bits of a 64x64 bit multiply in each lane. AVX2 only multiplies 32x32->64, so it's
+// built from three of those: lo*lo, plus the two cross products shifted up (hi*hi is all overflow).
+//---------------------------------------------------------
+__attribute__((target("avx2")))
+inline __m256i multiply64(__m256i lhs, __m256i rhs) {
+    __m256i low = _mm256_mul_epu32(lhs, rhs);
+    __m256i cross = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(lhs, 32), rhs),
+                                     _mm256_mul_epu32(lhs, _mm256_srli_epi64(rhs, 32)));
+    return _mm256_add_epi64(low, _mm256_slli_epi64(cross, 32));
+}
+
+//-------------------------------------------------------
+// Name: homeCellsAvx2
+// The scalar kernel 4 keys per step: the key's hash (identity, or SeededHash's multiply-xorshift
+// when Kind is 2), then mixHash and scaleHash, giving exactly the same home cells. cellCount has to
+// fit in 32 bits, like scaleHash needs anyway.
+//---------------------------------------------------------
+template<int Kind, class Key>
+__attribute__((target("avx2")))
+void homeCellsAvx2(const Key *keys, size_t count, size_t cellCount, uint64_t seed0, uint64_t seed1, size_t *homes) {
+
+    const __m256i mixer0 = _mm256_set1_epi64x(int64_t(0xff51afd7ed558ccdULL));
+    const __m256i mixer1 = _mm256_set1_epi64x(int64_t(0xc4ceb9fe1a85ec53ULL));
+    const __m256i cells = _mm256_set1_epi64x(int64_t(cellCount));
+    const __m256i seedKey = _mm256_set1_epi64x(int64_t(seed0));
+    const __m256i seedMultiplier0 = _mm256_set1_epi64x(int64_t(seed1 | 1));
+    const __m256i seedMultiplier1 = _mm256_set1_epi64x(int64_t((seed0 >> 1) | 1));
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        // Widen to 64 bits the way the hashers' conversion to size_t / uint64_t does
+        __m256i hashVal;
+        if constexpr (sizeof(Key) == 8) {
+            hashVal = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(keys + i));
+        } else if constexpr (std::is_signed_v<Key>) {
+            hashVal = _mm256_cvtepi32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i *>(keys + i)));
+        } else {
+            hashVal = _mm256_cvtepu32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i *>(keys + i)));
+        }
+
+        if constexpr (Kind == 2) {
+            hashVal = multiply64(_mm256_xor_si256(hashVal, seedKey), seedMultiplier0);
+            hashVal = _mm256_xor_si256(hashVal, _mm256_srli_epi64(hashVal, 32));
+            hashVal = multiply64(hashVal, seedMultiplier1);
+            hashVal = _mm256_xor_si256(hashVal, _mm256_srli_epi64(hashVal, 29));
+        }
+
+        hashVal = _mm256_xor_si256(hashVal, _mm256_srli_epi64(hashVal, 33));
+        hashVal = multiply64(hashVal, mixer0);
+        hashVal = _mm256_xor_si256(hashVal, _mm256_srli_epi64(hashVal, 33));
+        hashVal = multiply64(hashVal, mixer1);
+        hashVal = _mm256_xor_si256(hashVal, _mm256_srli_epi64(hashVal, 33));
+
+        __m256i high = _mm256_mul_epu32(_mm256_srli_epi64(hashVal, 32), cells);
+        __m256i low = _mm256_srli_epi64(_mm256_mul_epu32(hashVal, cells), 32);
+        __m256i home = _mm256_srli_epi64(_mm256_add_epi64(high, low), 32);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(homes + i), home);
+    }
+
+    // The last few keys, through the same hasher the table uses
+    for (; i < count; i++) {
+        if constexpr (Kind == 2) {
+            homes[i] = homeIndex(SeededHash<Key>(seed0, seed1)(keys[i]), cellCount);
+        } else {
+            homes[i] = homeIndex(std::hash<Key>{}(keys[i]), cellCount);
+        }
+    }
+}
+#endif
+
+//-------------------------------------------------------
+// Name: cpuHasAvx2
+// Asks the CPU once whether it supports AVX2, the answer is cached after that
+//---------------------------------------------------------
+inline bool cpuHasAvx2() {
+#ifdef HASHTABLE_HAVE_AVX2_KERNEL
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+#else
+    return false;
+#endif
+}
+
+//-------------------------------------------------------
+// Name: prefetchCell
+// Hints the CPU to start loading a cell we're about to probe, a no-op where there's no builtin
+//---------------------------------------------------------
+inline void prefetchCell(const void *cell) {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(cell);
+#else
+    (void) cell;
+#endif
+}
+
+//-------------------------------------------------------
+// Name: homeCells
+// Runtime dispatch: the AVX2 kernel when both the key/hasher pair and the CPU allow it, the
+// scalar kernel otherwise
+//---------------------------------------------------------
+template<class Key, class Hash>
+void homeCells(const Hash &hasher, const Key *keys, size_t count, size_t cellCount, size_t *homes) {
+#ifdef HASHTABLE_HAVE_AVX2_KERNEL
+    constexpr int kind = vectorHashKind<Key, Hash>();
+    if constexpr (kind != 0) {
+        if (cpuHasAvx2() && cellCount <= UINT32_MAX) {
+            if constexpr (kind == 2) {
+                homeCellsAvx2<kind>(keys, count, cellCount, hasher.first_seed(), hasher.second_seed(), homes);
+            } else {
+                homeCellsAvx2<kind>(keys, count, cellCount, 0, 0, homes);
+            }
+            return;
+        }
+    }
+#endif
+    homeCellsScalar(hasher, keys, count, cellCount, homes);
+}
+
+#endif  // HASHTABLE_BATCH_H
@@ -0,0 +1,567 @@
+/*****************************************
+** File:    hashtable_bucketized.h
+** Project: CSCE 221 Lab 6 Spring 2022
+** Author:  Joshua Hillis
+** Date:    04/12/2022
+** Section: 512
+** E-mail:  joshuahillis292002@tamu.edu
+**
+** This is the header file for the bucketized hashtable, a separate chaining layout built for the
+** cache. Every bucket is a 64 byte block holding as many keys as fit inline, along with a one
+** byte fingerprint of each key's hash, so a lookup compares fingerprints and usually only the
+** matching key before it's done, all within one cache line. Only a bucket that outgrows its block
+** chains on overflow blocks. Small keys get several slots per block (11 for an int), a key too
+** big to share a cache line gets a block of its own.
+**
+***********************************************/
+
+#ifndef HASHTABLE_BUCKETIZED_H
+#define HASHTABLE_BUCKETIZED_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <new>
+#include <utility>
+#include <vector>
+#include "hashtable_hash.h"
+#include "hashtable_primes.h"
+
+template<class Key, class Hash=std::hash<Key>>
+class BucketizedHashTable {
+public:
+    using key_type = Key;
+    using value_type = Key;
+    using hash = Hash;
+    using size_type = size_t;
+
+    // How many bytes a block takes up, one cache line on the CPUs we care about
+    static constexpr size_t blockBytes = 64;
+
+private:
+    // The most keys a block can hold and still fit in blockBytes: the overflow pointer, the count
+    // and the fingerprints come first, then the keys at their own alignment. Always at least 1.
+    static constexpr size_t fittingSlots() {
+        size_t slots = 1;
+        while (true) {
+            size_t next = slots + 1;
+            size_t header = sizeof(void *) + 1 + next;
+            size_t keysStart = (header + alignof(Key) - 1) / alignof(Key) * alignof(Key);
+            if (keysStart + next * sizeof(Key) > blockBytes) {
+                return slots;
+            }
+            slots = next;
+        }
+    }
+
+public:
+    static constexpr size_t slotsPerBlock = fittingSlots();
+
+private:
+    struct alignas(blockBytes) block {
+        // The bucket's next block once this one is full, or nullptr
+        block *next = nullptr;
+        // Slots [0, count) are in use, a bucket's keys are always packed to the front of its chain
+        unsigned char count = 0;
+        // The low byte of each key's mixed hash, the bucket comes from the high bits
+        unsigned char fingerprints[slotsPerBlock];
+        // The keys themselves, constructed in place as slots fill up
+        alignas(Key) unsigned char storage[slotsPerBlock * sizeof(Key)];
+
+        block() = default;
+        block(const block &) = delete;
+        block &operator=(const block &) = delete;
+
+        Key *keyAt(size_t slot) {
+            return std::launder(reinterpret_cast<Key *>(storage) + slot);
+        }
+
+        const Key *keyAt(size_t slot) const {
+            return std::launder(reinterpret_cast<const Key *>(storage) + slot);
+        }
+    };
+
+    // One block per bucket, with overflow blocks allocated separately. Stays empty (and
+    // unallocated) until the first insert, bucketCount is still 11.
+    std::vector<block> buckets;
+    size_t bucketCount;
+    size_t currentSize;
+    size_t overflowCount;
+    // Keys per slot, so 0.5 means the average bucket fills half of its first block
+    float maxLoad;
+    Hash hasher;
+
+    static unsigned char fingerprintOf(size_t hashCode);
+
+    std::pair<const block *, size_t> findSlot(const key_type &key, size_t hashCode) const;
+
+    void append(std::vector<block> &table, Key &&key, size_t hashCode);
+
+    void release();
+
+public:
+    BucketizedHashTable();
+
+    BucketizedHashTable(const BucketizedHashTable &other);
+
+    BucketizedHashTable &operator=(const BucketizedHashTable &other);
+
+    ~BucketizedHashTable();
+
+    explicit BucketizedHashTable(size_type buckets);
+
+    BucketizedHashTable(expected_size_t, size_type count);
+
+    bool is_empty() const;
+
+    size_t size() const;
+
+    size_t bucket_count() const;
+
+    size_t overflow_blocks() const;
+
+    float load_factor() const;
+
+    float max_load_factor() const;
+
+    void max_load_factor(float mlf);
+
+    void make_empty();
+
+    bool insert(const value_type &value);
+
+    size_t remove(const key_type &key);
+
+    bool contains(const key_type &key) const;
+
+    size_t lookup_blocks(const key_type &key) const;
+
+    void rehash(size_type count);
+
+    void reserve(size_type count);
+
+    std::vector<Key> keys() const;
+
+    template<class Fn>
+    void for_each(Fn fn) const;
+
+    hash hash_function() const;
+};
+
+//-------------------------------------------------------
+// Name: Default Constructor
+// Initializes an empty table with 11 buckets, which aren't allocated until the first insert
+//---------------------------------------------------------
+template<class Key, class Hash>
+BucketizedHashTable<Key, Hash>::BucketizedHashTable() {
+    bucketCount = 11;
+    currentSize = 0;
+    overflowCount = 0;
+    maxLoad = 0.5;
+}
+
+//-------------------------------------------------------
+// Name: Copy Constructor
+// Copies other's keys into a table of the same size, bucket by bucket
+//---------------------------------------------------------
+template<class Key, class Hash>
+BucketizedHashTable<Key, Hash>::BucketizedHashTable(const BucketizedHashTable &other) : BucketizedHashTable() {
+    *this = other;
+}
+
+//-------------------------------------------------------
+// Name: Equals operator
+// Replaces our keys with copies of other's, keeping its size, load factor and hasher
+//---------------------------------------------------------
+template<class Key, class Hash>
+BucketizedHashTable<Key, Hash> &BucketizedHashTable<Key, Hash>::operator=(const BucketizedHashTable &other) {
+
+    // Check for self assignment
+    if (this == &other) {
+        return *this;
+    }
+
+    release();
+    bucketCount = other.bucketCount;
+    maxLoad = other.maxLoad;
+    hasher = other.hasher;
+    if (!other.buckets.empty()) {
+        std::vector<block> table(bucketCount);
+        other.for_each([&](const Key &key) {
+            append(table, Key(key), hasher(key));
+        });
+        buckets = std::move(table);
+    }
+    currentSize = other.currentSize;
+    return *this;
+}
+
+//-------------------------------------------------------
+// Name: Destructor
+// Destroys every key and frees the overflow blocks, the vector frees the rest
+//---------------------------------------------------------
+template<class Key, class Hash>
+BucketizedHashTable<Key, Hash>::~BucketizedHashTable() {
+    release();
+}
+
+//-------------------------------------------------------
+// Name: Parameterized Constructor
+// Initializes a table with the given number of buckets, allocated right away
+//---------------------------------------------------------
+template<class Key, class Hash>
+BucketizedHashTable<Key, Hash>::BucketizedHashTable(size_type buckets) : BucketizedHashTable() {
+    bucketCount = std::max<size_t>(1, buckets);
+    this->buckets = std::vector<block>(bucketCount);
+}
+
+//-------------------------------------------------------
+// Name: Presizing Constructor
+// Initializes a table that is about to receive count keys, sized so none of them cause a rehash
+//---------------------------------------------------------
+template<class Key, class Hash>
+BucketizedHashTable<Key, Hash>::BucketizedHashTable(expected_size_t, size_type count) : BucketizedHashTable() {
+    reserve(count);
+}
+
+//-------------------------------------------------------
+// Name: is_empty
+// Returns true or false depending on whether the table is empty or not
+//---------------------------------------------------------
+template<class Key, class Hash>
+bool BucketizedHashTable<Key, Hash>::is_empty() const {
+    return currentSize == 0;
+}
+
+//-------------------------------------------------------
+// Name: size
+// Returns the number of keys in the table
+//---------------------------------------------------------
+template<class Key, class Hash>
+size_t BucketizedHashTable<Key, Hash>::size() const {
+    return currentSize;
+}
+
+//-------------------------------------------------------
+// Name: bucket_count
+// Returns the number of buckets, which is also the number of blocks not counting overflow ones
+//---------------------------------------------------------
+template<class Key, class Hash>
+size_t BucketizedHashTable<Key, Hash>::bucket_count() const {
+    return bucketCount;
+}
+
+//-------------------------------------------------------
+// Name: overflow_blocks
+// Returns how many overflow blocks the buckets that outgrew their own block are using
+//---------------------------------------------------------
+template<class Key, class Hash>
+size_t BucketizedHashTable<Key, Hash>::overflow_blocks() const {
+    return overflowCount;
+}
+
+//-------------------------------------------------------
+// Name: load_factor
+// Returns the keys per slot of the buckets' own blocks
+//---------------------------------------------------------
+template<class Key, class Hash>
+float BucketizedHashTable<Key, Hash>::load_factor() const {
+    return float(currentSize) / float(bucketCount * slotsPerBlock);
+}
+
+//-------------------------------------------------------
+// Name: max_load_factor
+// Returns the load factor past which the table doubles its buckets
+//---------------------------------------------------------
+template<class Key, class Hash>
+float BucketizedHashTable<Key, Hash>::max_load_factor() const {
+    return maxLoad;
+}
+
+//-------------------------------------------------------
+// Name: max_load_factor
+// Sets a new max load factor, rehashing right away if the table is already over it. Above about
+// 0.75 so many buckets overflow that lookups start needing a second cache line.
+//---------------------------------------------------------
+template<class Key, class Hash>
+void BucketizedHashTable<Key, Hash>::max_load_factor(float mlf) {
+    maxLoad = mlf;
+    if (load_factor() > maxLoad) {
+        reserve(currentSize);
+    }
+}
+
+//-------------------------------------------------------
+// Name: make_empty
+// Removes every key and frees the overflow blocks, keeping the bucket count
+//---------------------------------------------------------
+template<class Key, class Hash>
+void BucketizedHashTable<Key, Hash>::make_empty() {
+    if (buckets.empty()) {
+        return;
+    }
+    release();
+    buckets = std::vector<block>(bucketCount);
+}
+
+//-------------------------------------------------------
+// Name: insert
+// Adds the key to the end of its bucket if it isn't there yet, taking a new overflow block when
+// the last one is full, and doubles the buckets once the load factor goes over the max
+//---------------------------------------------------------
+template<class Key, class Hash>
+bool BucketizedHashTable<Key, Hash>::insert(const value_type &value) {
+
+    if (buckets.empty()) {
+        buckets = std::vector<block>(bucketCount);
+    }
+
+    size_t hashCode = hasher(value);
+    if (findSlot(value, hashCode).first != nullptr) {
+        return false;
+    }
+
+    append(buckets, Key(value), hashCode);
+    currentSize += 1;
+    if (load_factor() > maxLoad) {
+        rehash(HashPrimes::nextPrime(bucketCount * 2));
+    }
+    return true;
+}
+
+//-------------------------------------------------------
+// Name: remove
+// Removes the key if it's there. The bucket's last key moves into the gap, so the chain stays
+// packed, and an overflow block left empty by that is freed.
+//---------------------------------------------------------
+template<class Key, class Hash>
+size_t BucketizedHashTable<Key, Hash>::remove(const key_type &key) {
+
+    if (currentSize == 0) {
+        return 0;
+    }
+
+    size_t hashCode = hasher(key);
+    std::pair<const block *, size_t> found = findSlot(key, hashCode);
+    if (found.first == nullptr) {
+        return 0;
+    }
+    block *holder = const_cast<block *>(found.first);
+    size_t slot = found.second;
+
+    // Find the bucket's last block, and the one before it in case it ends up empty
+    block *previous = nullptr;
+    block *last = &buckets[homeIndex(hashCode, bucketCount)];
+    while (last->next != nullptr) {
+        previous = last;
+        last = last->next;
+    }
+
+    size_t tail = size_t(last->count) - 1;
+    if (holder != last || slot != tail) {
+        *holder->keyAt(slot) = std::move(*last->keyAt(tail));
+        holder->fingerprints[slot] = last->fingerprints[tail];
+    }
+    last->keyAt(tail)->~Key();
+    last->count -= 1;
+
+    if (last->count == 0 && previous != nullptr) {
+        previous->next = nullptr;
+        delete last;
+        overflowCount -= 1;
+    }
+    currentSize -= 1;
+    return 1;
+}
+
+//-------------------------------------------------------
+// Name: contains
+// Returns true or false depending on whether the key is in the table
+//---------------------------------------------------------
+template<class Key, class Hash>
+bool BucketizedHashTable<Key, Hash>::contains(const key_type &key) const {
+    return currentSize != 0 && findSlot(key, hasher(key)).first != nullptr;
+}
+
+//-------------------------------------------------------
+// Name: lookup_blocks
+// Returns how many blocks (so cache lines, for keys that fit several to a block) a lookup of the
+// key reads: up to the one holding it, or the bucket's whole chain if it isn't there
+//---------------------------------------------------------
+template<class Key, class Hash>
+size_t BucketizedHashTable<Key, Hash>::lookup_blocks(const key_type &key) const {
+
+    if (buckets.empty()) {
+        return 0;
+    }
+
+    size_t hashCode = hasher(key);
+    const block *found = findSlot(key, hashCode).first;
+    size_t blocks = 1;
+    for (const block *current = &buckets[homeIndex(hashCode, bucketCount)]; current != found && current->next != nullptr;
+         current = current->next) {
+        blocks += 1;
+    }
+    return blocks;
+}
+
+//-------------------------------------------------------
+// Name: rehash
+// Moves every key into a new array of count buckets, rehashing each one since blocks only keep
+// a byte of the hash
+//---------------------------------------------------------
+template<class Key, class Hash>
+void BucketizedHashTable<Key, Hash>::rehash(size_type count) {
+
+    size_t keys = currentSize;
+    size_t oldOverflow = overflowCount;
+    bucketCount = std::max<size_t>(1, count);
+    std::vector<block> table(bucketCount);
+    for (block &bucket : buckets) {
+        for (block *current = &bucket; current != nullptr; current = current->next) {
+            for (size_t slot = 0; slot < current->count; slot++) {
+                Key &key = *current->keyAt(slot);
+                append(table, std::move(key), hasher(key));
+            }
+        }
+    }
+
+    // The old blocks only hold moved-from keys now, and append counted the new overflow blocks on top of the old ones
+    size_t newOverflow = overflowCount - oldOverflow;
+    release();
+    overflowCount = newOverflow;
+    buckets = std::move(table);
+    currentSize = keys;
+}
+
+//-------------------------------------------------------
+// Name: reserve
+// Makes room for count keys under the current max load factor, so inserting that many never
+// triggers a rehash. It never shrinks the table.
+//---------------------------------------------------------
+template<class Key, class Hash>
+void BucketizedHashTable<Key, Hash>::reserve(size_type count) {
+    size_t needed = HashPrimes::nextPrime(size_t(float(count) / (maxLoad * float(slotsPerBlock))) + 1);
+    if (needed > bucketCount || buckets.empty()) {
+        rehash(std::max(needed, bucketCount));
+    }
+}
+
+//-------------------------------------------------------
+// Name: keys
+// Collects every key into a single vector
+//---------------------------------------------------------
+template<class Key, class Hash>
+std::vector<Key> BucketizedHashTable<Key, Hash>::keys() const {
+    std::vector<Key> result;
+    result.reserve(currentSize);
+    for_each([&result](const Key &key) {
+        result.push_back(key);
+    });
+    return result;
+}
+
+//-------------------------------------------------------
+// Name: for_each
+// Calls fn on every key, bucket by bucket, reading the blocks in place
+//---------------------------------------------------------
+template<class Key, class Hash>
+template<class Fn>
+void BucketizedHashTable<Key, Hash>::for_each(Fn fn) const {
+    for (const block &bucket : buckets) {
+        for (const block *current = &bucket; current != nullptr; current = current->next) {
+            for (size_t slot = 0; slot < current->count; slot++) {
+                fn(*current->keyAt(slot));
+            }
+        }
+    }
+}
+
+//-------------------------------------------------------
+// Name: hash_function
+// Returns a copy of the table's hasher
+//---------------------------------------------------------
+template<class Key, class Hash>
+typename BucketizedHashTable<Key, Hash>::hash BucketizedHashTable<Key, Hash>::hash_function() const {
+    return hasher;
+}
+
+//-------------------------------------------------------
+// Name: fingerprintOf
+// The byte of the hash a block keeps for each key. homeIndex picks the bucket from the high bits
+// of the mixed hash, so the low byte still tells keys in the same bucket apart.
+//---------------------------------------------------------
+template<class Key, class Hash>
+unsigned char BucketizedHashTable<Key, Hash>::fingerprintOf(size_t hashCode) {
+    return static_cast<unsigned char>(mixHash(hashCode));
+}
+
+//-------------------------------------------------------
+// Name: findSlot
+// Walks the key's bucket, only comparing the keys whose fingerprint matches. Returns the block
+// and slot holding the key, or a null block if it isn't there.
+//---------------------------------------------------------
+template<class Key, class Hash>
+std::pair<const typename BucketizedHashTable<Key, Hash>::block *, size_t>
+BucketizedHashTable<Key, Hash>::findSlot(const key_type &key, size_t hashCode) const {
+
+    unsigned char fingerprint = fingerprintOf(hashCode);
+    for (const block *current = &buckets[homeIndex(hashCode, bucketCount)]; current != nullptr; current = current->next) {
+        for (size_t slot = 0; slot < current->count; slot++) {
+            if (current->fingerprints[slot] == fingerprint && *current->keyAt(slot) == key) {
+                return {current, slot};
+            }
+        }
+    }
+    return {nullptr, 0};
+}
+
+//-------------------------------------------------------
+// Name: append
+// Moves a key into the first free slot at the end of its bucket in table, chaining a new overflow
+// block on when the last one is full. It doesn't check for duplicates or count the key.
+//---------------------------------------------------------
+template<class Key, class Hash>
+void BucketizedHashTable<Key, Hash>::append(std::vector<block> &table, Key &&key, size_t hashCode) {
+
+    block *last = &table[homeIndex(hashCode, table.size())];
+    while (last->next != nullptr) {
+        last = last->next;
+    }
+    if (last->count == slotsPerBlock) {
+        last->next = new block();
+        last = last->next;
+        overflowCount += 1;
+    }
+
+    new (last->storage + last->count * sizeof(Key)) Key(std::move(key));
+    last->fingerprints[last->count] = fingerprintOf(hashCode);
+    last->count += 1;
+}
+
+//-------------------------------------------------------
+// Name: release
+// Destroys every key and frees every overflow block, leaving the table with no buckets at all
+//---------------------------------------------------------
+template<class Key, class Hash>
+void BucketizedHashTable<Key, Hash>::release() {
+    for (block &bucket : buckets) {
+        block *current = &bucket;
+        while (current != nullptr) {
+            for (size_t slot = 0; slot < current->count; slot++) {
+                current->keyAt(slot)->~Key();
+            }
+            block *next = current->next;
+            if (current != &bucket) {
+                delete current;
+            }
+            current = next;
+        }
+    }
+    buckets.clear();
+    currentSize = 0;
+    overflowCount = 0;
+}
+
+#endif  // HASHTABLE_BUCKETIZED_H
@@ -0,0 +1,122 @@
+/*****************************************
+** File:    hashtable_constexpr.h
+** Project: CSCE 221 Lab 6 Spring 2022
+** Author:  Joshua Hillis
+** Date:    04/12/2022
+** Section: 512
+** E-mail:  joshuahillis292002@tamu.edu
+**
+** This is the header file for the compile-time hashtable. It is a fixed-capacity version of the
+** open addressing hashtable for small key sets that are known when the program is compiled,
+** like keyword tables. The whole table is built by the compiler, so there is no startup cost
+** and lookups can be inlined. It works with std::string_view and integral keys.
+**
+***********************************************/
+
+#ifndef HASHTABLE_CONSTEXPR_H
+#define HASHTABLE_CONSTEXPR_H
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+#include "hashtable_hash.h"
+#include "hashtable_primes.h"
+
+//-------------------------------------------------------
+// Name: ConstexprHash
+// std::hash can't run at compile time, so these stand in for it. Strings use FNV-1a and
+// integers use the splitmix64 finalizer.
+//---------------------------------------------------------
+template<class Key, class Enable = void>
+struct ConstexprHash;
+
+template<>
+struct ConstexprHash<std::string_view> {
+    constexpr size_t operator()(std::string_view value) const {
+        uint64_t hashVal = 0xcbf29ce484222325ULL;
+        for (char c : value) {
+            hashVal ^= static_cast<unsigned char>(c);
+            hashVal *= 0x100000001b3ULL;
+        }
+        return size_t(hashVal);
+    }
+};
+
+template<class Key>
+struct ConstexprHash<Key, std::enable_if_t<std::is_integral_v<Key>>> {
+    constexpr size_t operator()(Key value) const {
+        uint64_t hashVal = static_cast<uint64_t>(value);
+        hashVal ^= hashVal >> 30;
+        hashVal *= 0xbf58476d1ce4e5b9ULL;
+        hashVal ^= hashVal >> 27;
+        hashVal *= 0x94d049bb133111ebULL;
+        hashVal ^= hashVal >> 31;
+        return size_t(hashVal);
+    }
+};
+
+template<class Key, size_t N, class Hash=ConstexprHash<Key>>
+class ConstexprHashTable {
+public:
+    using key_type = Key;
+    using value_type = Key;
+    using hash = Hash;
+    using size_type = size_t;
+
+    // Keep the load factor at or under 0.5 like the open addressing table, so probing always ends
+    static constexpr size_t cellCount = HashPrimes::nextPrime(2 * N + 1);
+
+private:
+    // Same states as the open addressing cells, but there is never a deleted one
+    std::array<Key, cellCount> data{};
+    std::array<bool, cellCount> occupied{};
+    size_t currentSize = 0;
+
+public:
+    constexpr explicit ConstexprHashTable(const std::array<Key, N> &keys) {
+        for (size_t i = 0; i < N; i++) {
+            size_t index = position(keys[i]);
+            if (!occupied[index]) {
+                data[index] = keys[i];
+                occupied[index] = true;
+                currentSize += 1;
+            }
+        }
+    }
+
+    constexpr size_t size() const {
+        return currentSize;
+    }
+
+    constexpr size_t table_size() const {
+        return cellCount;
+    }
+
+    constexpr bool contains(const key_type &key) const {
+        return occupied[position(key)];
+    }
+
+    // The same home cell and quadratic probing as HashTable::position in the open addressing table
+    constexpr size_t position(const key_type &key) const {
+        return quadraticProbe(homeIndex(Hash{}(key), cellCount), cellCount, [this, &key](size_t currentIndex) {
+            return !occupied[currentIndex] || data[currentIndex] == key;
+        });
+    }
+};
+
+//-------------------------------------------------------
+// Name: make_constexpr_table
+// Builds a compile-time table from a braced list, e.g.
+//     constexpr auto keywords = make_constexpr_table<std::string_view>({"if", "else", "while"});
+//---------------------------------------------------------
+template<class Key, class Hash=ConstexprHash<Key>, size_t N>
+constexpr ConstexprHashTable<Key, N, Hash> make_constexpr_table(const Key (&keys)[N]) {
+    std::array<Key, N> keyArray{};
+    for (size_t i = 0; i < N; i++) {
+        keyArray[i] = keys[i];
+    }
+    return ConstexprHashTable<Key, N, Hash>(keyArray);
+}
+
+#endif  // HASHTABLE_CONSTEXPR_H
@@ -0,0 +1,226 @@
+/*****************************************
+** File:    hashtable_frozen.h
+** Project: CSCE 221 Lab 6 Spring 2022
+** Author:  Joshua Hillis
+** Date:    04/12/2022
+** Section: 512
+** E-mail:  joshuahillis292002@tamu.edu
+**
+** This is the header file for the frozen hashtable. It is an immutable, read-only copy of
+** either hashtable, laid out CSR-style: one array of bucket offsets and one contiguous array
+** of keys, so there are no per-node pointers and no empty cells. Strings are packed into a
+** single character blob with their own offset array.
+**
+***********************************************/
+
+#ifndef HASHTABLE_FROZEN_H
+#define HASHTABLE_FROZEN_H
+
+#include <functional>
+#include <string>
+#include <vector>
+#include "hashtable_hash.h"
+#include "hashtable_primes.h"
+
+template<class Key, class Hash=std::hash<Key>>
+class FrozenHashTable {
+public:
+    using key_type = Key;
+    using value_type = Key;
+    using hash = Hash;
+    using size_type = size_t;
+
+private:
+    // offsets[b] to offsets[b + 1] is the range of keys that live in bucket b
+    std::vector<size_t> offsets;
+    std::vector<Key> keys;
+    size_t bucketCount;
+    Hash hasher;
+
+public:
+    FrozenHashTable();
+
+    explicit FrozenHashTable(const std::vector<Key> &values, const Hash &hashFunction = Hash());
+
+    bool is_empty() const;
+
+    size_t size() const;
+
+    size_t bucket_count() const;
+
+    bool contains(const key_type &key) const;
+};
+
+//-------------------------------------------------------
+// Name: Default Constructor
+// Initializes an empty frozen hashtable with a single bucket
+//---------------------------------------------------------
+template<class Key, class Hash>
+FrozenHashTable<Key, Hash>::FrozenHashTable() {
+    bucketCount = 1;
+    offsets = std::vector<size_t>(bucketCount + 1, 0);
+}
+
+//-------------------------------------------------------
+// Name: Parameterized Constructor
+// Builds the frozen table from a list of unique keys, one bucket per key on average
+//---------------------------------------------------------
+template<class Key, class Hash>
+FrozenHashTable<Key, Hash>::FrozenHashTable(const std::vector<Key> &values, const Hash &hashFunction) {
+
+    // Keep the source table's hasher, a seeded one would otherwise hash everything differently
+    hasher = hashFunction;
+
+    bucketCount = HashPrimes::nextPrime(values.size());
+    offsets = std::vector<size_t>(bucketCount + 1, 0);
+
+    // Count how many keys land in each bucket, shifted by one so the prefix sum gives start offsets
+    std::vector<size_t> homes(values.size());
+    for (size_t i = 0; i < values.size(); i++) {
+        homes.at(i) = homeIndex(hasher(values.at(i)), bucketCount);
+        offsets.at(homes.at(i) + 1) += 1;
+    }
+    for (size_t b = 0; b < bucketCount; b++) {
+        offsets.at(b + 1) += offsets.at(b);
+    }
+
+    // Drop each key into the next free slot of its bucket
+    std::vector<size_t> fill(offsets.begin(), offsets.end() - 1);
+    keys = std::vector<Key>(values.size());
+    for (size_t i = 0; i < values.size(); i++) {
+        keys.at(fill.at(homes.at(i))++) = values.at(i);
+    }
+}
+
+//-------------------------------------------------------
+// Name: is_empty
+// Returns true or false depending on whether the frozen table holds any keys
+//---------------------------------------------------------
+template<class Key, class Hash>
+bool FrozenHashTable<Key, Hash>::is_empty() const {
+    return keys.empty();
+}
+
+//-------------------------------------------------------
+// Name: size
+// Returns the number of keys stored in the frozen table
+//---------------------------------------------------------
+template<class Key, class Hash>
+size_t FrozenHashTable<Key, Hash>::size() const {
+    return keys.size();
+}
+
+//-------------------------------------------------------
+// Name: bucket_count
+// Returns the number of buckets in the offsets array
+//---------------------------------------------------------
+template<class Key, class Hash>
+size_t FrozenHashTable<Key, Hash>::bucket_count() const {
+    return bucketCount;
+}
+
+//-------------------------------------------------------
+// Name: contains
+// Returns true or false depending on whether the key exists in the frozen table
+//---------------------------------------------------------
+template<class Key, class Hash>
+bool FrozenHashTable<Key, Hash>::contains(const key_type &key) const {
+
+    size_t b = homeIndex(hasher(key), bucketCount);
+
+    // The bucket's keys are contiguous, so this is a short linear scan
+    for (size_t i = offsets[b]; i < offsets[b + 1]; i++) {
+        if (keys[i] == key) {
+            return true;
+        }
+    }
+    return false;
+}
+
+//-------------------------------------------------------
+// Name: FrozenHashTable<std::string>
+// String keys are packed back to back into one blob, with keyOffsets[i] to keyOffsets[i + 1]
+// giving the characters of the i-th key, so a lookup never chases a heap pointer per string.
+//---------------------------------------------------------
+template<class Hash>
+class FrozenHashTable<std::string, Hash> {
+public:
+    using key_type = std::string;
+    using value_type = std::string;
+    using hash = Hash;
+    using size_type = size_t;
+
+private:
+    std::vector<size_t> offsets;
+    std::vector<size_t> keyOffsets;
+    std::string blob;
+    size_t bucketCount;
+    Hash hasher;
+
+public:
+    FrozenHashTable() {
+        bucketCount = 1;
+        offsets = std::vector<size_t>(bucketCount + 1, 0);
+        keyOffsets = std::vector<size_t>(1, 0);
+    }
+
+    explicit FrozenHashTable(const std::vector<std::string> &values, const Hash &hashFunction = Hash()) {
+
+        hasher = hashFunction;
+
+        bucketCount = HashPrimes::nextPrime(values.size());
+        offsets = std::vector<size_t>(bucketCount + 1, 0);
+
+        std::vector<size_t> homes(values.size());
+        size_t totalLength = 0;
+        for (size_t i = 0; i < values.size(); i++) {
+            homes.at(i) = homeIndex(hasher(values.at(i)), bucketCount);
+            offsets.at(homes.at(i) + 1) += 1;
+            totalLength += values.at(i).size();
+        }
+        for (size_t b = 0; b < bucketCount; b++) {
+            offsets.at(b + 1) += offsets.at(b);
+        }
+
+        // Work out which slot each key goes to, then lay the characters out in slot order
+        std::vector<size_t> fill(offsets.begin(), offsets.end() - 1);
+        std::vector<size_t> slotOwner(values.size());
+        for (size_t i = 0; i < values.size(); i++) {
+            slotOwner.at(fill.at(homes.at(i))++) = i;
+        }
+
+        blob.reserve(totalLength);
+        keyOffsets = std::vector<size_t>(values.size() + 1, 0);
+        for (size_t slot = 0; slot < values.size(); slot++) {
+            blob += values.at(slotOwner.at(slot));
+            keyOffsets.at(slot + 1) = blob.size();
+        }
+    }
+
+    bool is_empty() const {
+        return keyOffsets.size() == 1;
+    }
+
+    size_t size() const {
+        return keyOffsets.size() - 1;
+    }
+
+    size_t bucket_count() const {
+        return bucketCount;
+    }
+
+    bool contains(const key_type &key) const {
+
+        size_t b = homeIndex(hasher(key), bucketCount);
+
+        for (size_t i = offsets[b]; i < offsets[b + 1]; i++) {
+            size_t length = keyOffsets[i + 1] - keyOffsets[i];
+            if (length == key.size() && blob.compare(keyOffsets[i], length, key) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+#endif  // HASHTABLE_FROZEN_H
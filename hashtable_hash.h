@@ -0,0 +1,509 @@
+/*****************************************
+** File:    hashtable_hash.h
+** Project: CSCE 221 Lab 6 Spring 2022
+** Author:  Joshua Hillis
+** Date:    04/12/2022
+** Section: 512
+** E-mail:  joshuahillis292002@tamu.edu
+**
+** This is the header file for the hash functors that can be plugged into the Hash parameter of
+** either hashtable in place of std::hash: transparent, seeded (HashDoS resistant) and fast
+** long-key string hashes. It also holds the small tag types both tables' constructors share.
+**
+***********************************************/
+
+#ifndef HASHTABLE_HASH_H
+#define HASHTABLE_HASH_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+//-------------------------------------------------------
+// Name: StringHash
+// Transparent string hash. Because it is marked is_transparent, HashTable<std::string, StringHash>
+// can look up a std::string_view or const char* directly instead of building a std::string first.
+// It gives the same values as std::hash<std::string>.
+//---------------------------------------------------------
+struct StringHash {
+    using is_transparent = void;
+
+    size_t operator()(std::string_view value) const noexcept {
+        return std::hash<std::string_view>{}(value);
+    }
+
+    size_t operator()(const std::string &value) const noexcept {
+        return std::hash<std::string_view>{}(value);
+    }
+
+    size_t operator()(const char *value) const noexcept {
+        return std::hash<std::string_view>{}(value);
+    }
+};
+
+//-------------------------------------------------------
+// Name: SeededHash
+// Keyed hash with a random seed drawn per instance, so an attacker can't precompute keys that
+// collide. The tables keep their own copy of the hasher, which makes the seed per table, and
+// SeededHashTable<Key> in either table header is the shorthand for a table that uses it.
+// Strings use SipHash-1-3, integers a seeded multiply-xorshift. Only strings and integral keys
+// are supported; it is transparent for strings like StringHash.
+//---------------------------------------------------------
+template<class Key, class Enable = void>
+class SeededHash;
+
+// Shared seed handling for the specializations below
+class SeededHashBase {
+protected:
+    uint64_t seed0;
+    uint64_t seed1;
+
+    // The process reads random_device once, and every hasher after that takes the next value of a
+    // counter on top of it. splitmix64 makes consecutive seeds look unrelated.
+    SeededHashBase() {
+        static const uint64_t processSeed = [] {
+            std::random_device device;
+            return (uint64_t(device()) << 32) | device();
+        }();
+        static std::atomic<uint64_t> counter{0};
+
+        uint64_t state = processSeed + 2 * 0x9e3779b97f4a7c15ULL * counter.fetch_add(1, std::memory_order_relaxed);
+        seed0 = splitMix(state);
+        seed1 = splitMix(state);
+    }
+
+    static uint64_t splitMix(uint64_t &state) {
+        state += 0x9e3779b97f4a7c15ULL;
+        uint64_t value = state;
+        value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+        return value ^ (value >> 31);
+    }
+
+    SeededHashBase(uint64_t first, uint64_t second) : seed0{first}, seed1{second} {}
+
+public:
+    uint64_t seed() const noexcept {
+        return seed0 ^ seed1;
+    }
+
+    // The two halves of the key, for code that has to reproduce the hash (the batch kernels)
+    uint64_t first_seed() const noexcept {
+        return seed0;
+    }
+
+    uint64_t second_seed() const noexcept {
+        return seed1;
+    }
+};
+
+template<>
+class SeededHash<std::string> : public SeededHashBase {
+    static uint64_t rotate(uint64_t value, int bits) {
+        return (value << bits) | (value >> (64 - bits));
+    }
+
+    static void sipRound(uint64_t &v0, uint64_t &v1, uint64_t &v2, uint64_t &v3) {
+        v0 += v1; v1 = rotate(v1, 13); v1 ^= v0; v0 = rotate(v0, 32);
+        v2 += v3; v3 = rotate(v3, 16); v3 ^= v2;
+        v0 += v3; v3 = rotate(v3, 21); v3 ^= v0;
+        v2 += v1; v1 = rotate(v1, 17); v1 ^= v2; v2 = rotate(v2, 32);
+    }
+
+public:
+    using is_transparent = void;
+
+    SeededHash() = default;
+
+    SeededHash(uint64_t first, uint64_t second) : SeededHashBase(first, second) {}
+
+    // SipHash-1-3: one compression round per 8 byte block and three finalization rounds
+    size_t operator()(std::string_view value) const noexcept {
+        uint64_t v0 = seed0 ^ 0x736f6d6570736575ULL;
+        uint64_t v1 = seed1 ^ 0x646f72616e646f6dULL;
+        uint64_t v2 = seed0 ^ 0x6c7967656e657261ULL;
+        uint64_t v3 = seed1 ^ 0x7465646279746573ULL;
+
+        const char *data = value.data();
+        size_t length = value.size();
+        size_t blocks = length / 8;
+        for (size_t i = 0; i < blocks; i++) {
+            uint64_t block;
+            std::memcpy(&block, data + i * 8, 8);
+            v3 ^= block;
+            sipRound(v0, v1, v2, v3);
+            v0 ^= block;
+        }
+
+        // The last block holds the leftover bytes and the length in its top byte
+        uint64_t last = uint64_t(length) << 56;
+        for (size_t i = 0; i < length % 8; i++) {
+            last |= uint64_t(static_cast<unsigned char>(data[blocks * 8 + i])) << (8 * i);
+        }
+        v3 ^= last;
+        sipRound(v0, v1, v2, v3);
+        v0 ^= last;
+
+        v2 ^= 0xff;
+        sipRound(v0, v1, v2, v3);
+        sipRound(v0, v1, v2, v3);
+        sipRound(v0, v1, v2, v3);
+        return size_t(v0 ^ v1 ^ v2 ^ v3);
+    }
+
+    size_t operator()(const std::string &value) const noexcept {
+        return (*this)(std::string_view(value));
+    }
+
+    size_t operator()(const char *value) const noexcept {
+        return (*this)(std::string_view(value));
+    }
+};
+
+template<>
+class SeededHash<std::string_view> : public SeededHash<std::string> {
+public:
+    using SeededHash<std::string>::SeededHash;
+};
+
+template<class Key>
+class SeededHash<Key, std::enable_if_t<std::is_integral_v<Key>>> : public SeededHashBase {
+public:
+    SeededHash() = default;
+
+    SeededHash(uint64_t first, uint64_t second) : SeededHashBase(first, second) {}
+
+    // Multiply-xorshift with both multipliers coming from the seed (forced odd so they're invertible)
+    size_t operator()(Key value) const noexcept {
+        uint64_t hashVal = uint64_t(value) ^ seed0;
+        hashVal *= seed1 | 1;
+        hashVal ^= hashVal >> 32;
+        hashVal *= (seed0 >> 1) | 1;
+        hashVal ^= hashVal >> 29;
+        return size_t(hashVal);
+    }
+};
+
+//-------------------------------------------------------
+// Name: FastHashBase
+// Byte reading and 64x64->128 bit multiply helpers for the long-key string hashes below
+//---------------------------------------------------------
+class FastHashBase {
+protected:
+    static constexpr uint64_t prime0 = 0xa0761d6478bd642fULL;
+    static constexpr uint64_t prime1 = 0xe7037ed1a0b428dbULL;
+    static constexpr uint64_t prime2 = 0x8ebc6af09c88c6e3ULL;
+    static constexpr uint64_t prime3 = 0x589965cc75374cc3ULL;
+
+    static uint64_t read8(const char *data) {
+        uint64_t value;
+        std::memcpy(&value, data, 8);
+        return value;
+    }
+
+    static uint64_t read4(const char *data) {
+        uint32_t value;
+        std::memcpy(&value, data, 4);
+        return value;
+    }
+
+    // Multiplies into 128 bits and returns both halves in place
+    static void multiply(uint64_t &lhs, uint64_t &rhs) {
+#if defined(__SIZEOF_INT128__)
+        __uint128_t product = __uint128_t(lhs) * rhs;
+        lhs = uint64_t(product);
+        rhs = uint64_t(product >> 64);
+#else
+        uint64_t hh = (lhs >> 32) * (rhs >> 32), hl = (lhs >> 32) * uint32_t(rhs);
+        uint64_t lh = uint32_t(lhs) * (rhs >> 32), ll = uint64_t(uint32_t(lhs)) * uint32_t(rhs);
+        uint64_t middle = hl + (ll >> 32) + uint32_t(lh);
+        lhs = (middle << 32) | uint32_t(ll);
+        rhs = hh + (middle >> 32) + (lh >> 32);
+#endif
+    }
+
+    // Folds a 128 bit product back down to 64 bits
+    static uint64_t mix(uint64_t lhs, uint64_t rhs) {
+        multiply(lhs, rhs);
+        return lhs ^ rhs;
+    }
+
+    // wyhash's short input path, also used for the tail of the longer hashes
+    static uint64_t shortHash(const char *data, size_t length, uint64_t seed) {
+        uint64_t a = 0;
+        uint64_t b = 0;
+        if (length >= 4) {
+            size_t middle = (length >> 3) << 2;
+            a = (read4(data) << 32) | read4(data + middle);
+            b = (read4(data + length - 4) << 32) | read4(data + length - 4 - middle);
+        } else if (length > 0) {
+            a = (uint64_t(static_cast<unsigned char>(data[0])) << 16)
+                | (uint64_t(static_cast<unsigned char>(data[length >> 1])) << 8)
+                | static_cast<unsigned char>(data[length - 1]);
+        }
+        a ^= prime1;
+        b ^= seed;
+        multiply(a, b);
+        return mix(a ^ prime0 ^ length, b ^ prime1);
+    }
+};
+
+//-------------------------------------------------------
+// Name: WyHash
+// wyhash-style string hash. Keys up to 16 bytes are one multiply, longer ones are eaten 16 bytes
+// per multiply, and keys over 48 bytes run three independent lanes so the multiplies overlap.
+// Transparent for strings.
+//---------------------------------------------------------
+class WyHash : public FastHashBase {
+    uint64_t seed;
+
+public:
+    using is_transparent = void;
+
+    explicit WyHash(uint64_t seedValue = 0) : seed{seedValue} {}
+
+    size_t operator()(std::string_view value) const noexcept {
+        const char *data = value.data();
+        size_t length = value.size();
+        uint64_t state = seed ^ mix(seed ^ prime0, prime1);
+
+        if (length <= 16) {
+            return size_t(shortHash(data, length, state));
+        }
+
+        size_t remaining = length;
+        if (remaining > 48) {
+            uint64_t lane1 = state;
+            uint64_t lane2 = state;
+            do {
+                state = mix(read8(data) ^ prime1, read8(data + 8) ^ state);
+                lane1 = mix(read8(data + 16) ^ prime2, read8(data + 24) ^ lane1);
+                lane2 = mix(read8(data + 32) ^ prime3, read8(data + 40) ^ lane2);
+                data += 48;
+                remaining -= 48;
+            } while (remaining > 48);
+            state ^= lane1 ^ lane2;
+        }
+        while (remaining > 16) {
+            state = mix(read8(data) ^ prime1, read8(data + 8) ^ state);
+            data += 16;
+            remaining -= 16;
+        }
+
+        // The last 16 bytes of the key, which may overlap what we already ate
+        uint64_t a = read8(data + remaining - 16) ^ prime1;
+        uint64_t b = read8(data + remaining - 8) ^ state;
+        multiply(a, b);
+        return size_t(mix(a ^ prime0 ^ length, b ^ prime1));
+    }
+
+    size_t operator()(const std::string &value) const noexcept {
+        return (*this)(std::string_view(value));
+    }
+
+    size_t operator()(const char *value) const noexcept {
+        return (*this)(std::string_view(value));
+    }
+};
+
+//-------------------------------------------------------
+// Name: StripeHash
+// XXH3-style string hash for long keys. Keys are read in 64 byte stripes into eight 64 bit
+// accumulators with 32x32->64 bit multiplies, which map directly onto SSE2 (used when the compiler
+// targets it, with a scalar fallback that gives identical values). Like XXH3, each stripe of a
+// block is keyed with the secret read from a different offset, so the same bytes in a different
+// stripe hash differently and reordering stripes changes the hash. Keys under 64 bytes use WyHash.
+// Transparent for strings.
+//---------------------------------------------------------
+class StripeHash : public FastHashBase {
+    static constexpr size_t stripeLength = 64;
+    static constexpr size_t stripesPerScramble = 16;
+    // Stripe i of a block is keyed with secret[i .. i + 7], the last stripe of the key with
+    // secret[16 .. 23] and the scrambles with secret[24 .. 31]
+    static constexpr size_t lastStripeOffset = stripesPerScramble;
+    static constexpr size_t scrambleOffset = lastStripeOffset + 8;
+    static constexpr size_t secretWords = scrambleOffset + 8;
+
+    uint64_t secret[secretWords];
+
+#if !defined(__SSE2__)
+    // One stripe: acc[i] += lo32(d ^ k) * hi32(d ^ k), and the raw data goes to the neighbor lane
+    static void accumulate(uint64_t *acc, const uint64_t *keys, const char *data) {
+        for (int i = 0; i < 8; i++) {
+            uint64_t lane = read8(data + 8 * i);
+            uint64_t dataKey = lane ^ keys[i];
+            acc[i ^ 1] += lane;
+            acc[i] += (dataKey & 0xffffffffULL) * (dataKey >> 32);
+        }
+    }
+#else
+    // The same stripe step two lanes at a time
+    static void accumulate(__m128i *acc, const uint64_t *keys, const char *data) {
+        for (int i = 0; i < 4; i++) {
+            __m128i dataVec = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data) + i);
+            __m128i keyVec = _mm_loadu_si128(reinterpret_cast<const __m128i *>(keys) + i);
+            __m128i dataKey = _mm_xor_si128(dataVec, keyVec);
+            __m128i product = _mm_mul_epu32(dataKey, _mm_shuffle_epi32(dataKey, _MM_SHUFFLE(0, 3, 0, 1)));
+            __m128i swapped = _mm_shuffle_epi32(dataVec, _MM_SHUFFLE(1, 0, 3, 2));
+            acc[i] = _mm_add_epi64(acc[i], _mm_add_epi64(product, swapped));
+        }
+    }
+#endif
+
+    // Keeps the accumulators from saturating their low bits on very long keys
+    void scramble(uint64_t *acc) const {
+        for (int i = 0; i < 8; i++) {
+            acc[i] ^= acc[i] >> 47;
+            acc[i] ^= secret[scrambleOffset + i];
+            acc[i] *= 0x9e3779b1ULL;
+        }
+    }
+
+public:
+    using is_transparent = void;
+
+    explicit StripeHash(uint64_t seed = 0) {
+        // Derive the secret from the seed with splitmix64
+        uint64_t state = seed;
+        for (uint64_t &key : secret) {
+            state += 0x9e3779b97f4a7c15ULL;
+            uint64_t value = state;
+            value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+            key = value ^ (value >> 31);
+        }
+    }
+
+    size_t operator()(std::string_view value) const noexcept {
+        const char *data = value.data();
+        size_t length = value.size();
+
+        if (length < stripeLength) {
+            return WyHash(secret[0])(value);
+        }
+
+        uint64_t acc[8] = {prime0, prime1, prime2, prime3, prime0 ^ length, prime1, prime2, prime3};
+        size_t stripes = (length - 1) / stripeLength;
+
+#if defined(__SSE2__)
+        // Same steps as the scalar loop below, with the accumulators held in SSE2 registers
+        __m128i accVec[4];
+        for (int i = 0; i < 4; i++) {
+            accVec[i] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(acc) + i);
+        }
+        for (size_t i = 0; i < stripes; i++) {
+            accumulate(accVec, secret + i % stripesPerScramble, data + i * stripeLength);
+            if ((i + 1) % stripesPerScramble == 0) {
+                for (int j = 0; j < 4; j++) {
+                    _mm_storeu_si128(reinterpret_cast<__m128i *>(acc) + j, accVec[j]);
+                }
+                scramble(acc);
+                for (int j = 0; j < 4; j++) {
+                    accVec[j] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(acc) + j);
+                }
+            }
+        }
+        accumulate(accVec, secret + lastStripeOffset, data + length - stripeLength);
+        for (int i = 0; i < 4; i++) {
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(acc) + i, accVec[i]);
+        }
+#else
+        for (size_t i = 0; i < stripes; i++) {
+            accumulate(acc, secret + i % stripesPerScramble, data + i * stripeLength);
+            if ((i + 1) % stripesPerScramble == 0) {
+                scramble(acc);
+            }
+        }
+        // The final stripe is the last 64 bytes of the key, overlapping the previous one if needed
+        accumulate(acc, secret + lastStripeOffset, data + length - stripeLength);
+#endif
+
+        uint64_t result = length * prime0;
+        for (int i = 0; i < 8; i += 2) {
+            result += mix(acc[i] ^ secret[i], acc[i + 1] ^ secret[i + 1]);
+        }
+        result ^= result >> 37;
+        result *= 0x165667919e3779f9ULL;
+        result ^= result >> 32;
+        return size_t(result);
+    }
+
+    size_t operator()(const std::string &value) const noexcept {
+        return (*this)(std::string_view(value));
+    }
+
+    size_t operator()(const char *value) const noexcept {
+        return (*this)(std::string_view(value));
+    }
+};
+
+//-------------------------------------------------------
+// Name: mixHash
+// The murmur3 finalizer. Both tables mix every hash before picking a bucket with it, so hashers
+// that leave the high bits empty (std::hash is the identity on integers) still spread out.
+//---------------------------------------------------------
+constexpr uint64_t mixHash(uint64_t hashVal) {
+    hashVal ^= hashVal >> 33;
+    hashVal *= 0xff51afd7ed558ccdULL;
+    hashVal ^= hashVal >> 33;
+    hashVal *= 0xc4ceb9fe1a85ec53ULL;
+    hashVal ^= hashVal >> 33;
+    return hashVal;
+}
+
+//-------------------------------------------------------
+// Name: scaleHash
+// Maps a mixed hash onto [0, count) with a multiply, the high half of mixed * count, instead of a
+// modulo. Unlike a modulo it's monotone: a bigger mixed hash never lands in an earlier bucket, for
+// any count, which is what lets a scan cursor survive a resize. count has to fit in 32 bits.
+//---------------------------------------------------------
+constexpr size_t scaleHash(uint64_t mixed, size_t count) {
+    uint64_t high = (mixed >> 32) * count;
+    uint64_t low = ((mixed & 0xffffffffULL) * count) >> 32;
+    return size_t((high + low) >> 32);
+}
+
+//-------------------------------------------------------
+// Name: homeIndex
+// The bucket (or home cell) of a hash in a table with count of them
+//---------------------------------------------------------
+constexpr size_t homeIndex(size_t hashVal, size_t count) {
+    return scaleHash(mixHash(hashVal), count);
+}
+
+//-------------------------------------------------------
+// Name: homeStart
+// The inverse of scaleHash: the smallest mixed hash that lands in bucket index or later, which is
+// ceil(index * 2^64 / count). index has to be under count.
+//---------------------------------------------------------
+constexpr uint64_t homeStart(size_t index, size_t count) {
+    // 2^64 = quotient * count + remainder, worked out without 128 bit arithmetic
+    uint64_t quotient = UINT64_MAX / count;
+    uint64_t remainder = UINT64_MAX % count + 1;
+    if (remainder == count) {
+        quotient += 1;
+        remainder = 0;
+    }
+    return index * quotient + (index * remainder + count - 1) / count;
+}
+
+//-------------------------------------------------------
+// Name: expected_size
+// Tag for the constructor that takes how many keys are coming rather than a bucket/cell count,
+// e.g. HashTable<int> table(expected_size, 1000000);
+//---------------------------------------------------------
+struct expected_size_t {
+    explicit expected_size_t() = default;
+};
+inline constexpr expected_size_t expected_size{};
+
+#endif  // HASHTABLE_HASH_H
@@ -0,0 +1,588 @@
+/*****************************************
+** File:    hashtable_inline.h
+** Project: CSCE 221 Lab 6 Spring 2022
+** Author:  Joshua Hillis
+** Date:    04/12/2022
+** Section: 512
+** E-mail:  joshuahillis292002@tamu.edu
+**
+** This is the header file for the inline-first hashtable, a separate chaining layout where the
+** first key of every bucket lives in the bucket array itself and only the keys after it get a
+** node. At the default max load of 1 most buckets hold no more than one key, so most hits read the
+** bucket array and nothing else, where the list layout always has to follow a pointer from the
+** bucket's list to a heap node first.
+**
+***********************************************/
+
+#ifndef HASHTABLE_INLINE_H
+#define HASHTABLE_INLINE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <utility>
+#include <vector>
+#include "hashtable_hash.h"
+#include "hashtable_primes.h"
+
+template<class Key, class Hash=std::hash<Key>>
+class InlineHashTable {
+public:
+    using key_type = Key;
+    using value_type = Key;
+    using hash = Hash;
+    using size_type = size_t;
+
+private:
+    // A key past the first one in its bucket
+    struct overflowNode {
+        overflowNode *next;
+        size_t hashCode;
+        Key key;
+    };
+
+    struct slot {
+        // The rest of the bucket, newest first, or nullptr
+        overflowNode *next = nullptr;
+        // The full hash of the inline key, so rehashing and mismatches never call the hasher or compare keys
+        size_t hashCode = 0;
+        // The bucket's first key, constructed in place while occupied is set
+        alignas(Key) unsigned char storage[sizeof(Key)];
+        bool occupied = false;
+
+        slot() = default;
+        slot(const slot &) = delete;
+        slot &operator=(const slot &) = delete;
+
+        Key *key() {
+            return std::launder(reinterpret_cast<Key *>(storage));
+        }
+
+        const Key *key() const {
+            return std::launder(reinterpret_cast<const Key *>(storage));
+        }
+    };
+
+    // One slot per bucket. Stays empty (and unallocated) until the first insert, bucketCount is still 11.
+    std::vector<slot> buckets;
+    size_t bucketCount;
+    size_t currentSize;
+    size_t overflowCount;
+    float maxLoad;
+    Hash hasher;
+
+    const Key *findKey(const key_type &key, size_t hashCode) const;
+
+    void place(std::vector<slot> &table, Key &&key, size_t hashCode);
+
+    void release();
+
+public:
+    InlineHashTable();
+
+    InlineHashTable(const InlineHashTable &other);
+
+    InlineHashTable &operator=(const InlineHashTable &other);
+
+    ~InlineHashTable();
+
+    explicit InlineHashTable(size_type buckets);
+
+    InlineHashTable(expected_size_t, size_type count);
+
+    bool is_empty() const;
+
+    size_t size() const;
+
+    size_t bucket_count() const;
+
+    size_t bucket_size(size_t n) const;
+
+    size_t overflow_nodes() const;
+
+    float load_factor() const;
+
+    float max_load_factor() const;
+
+    void max_load_factor(float mlf);
+
+    void make_empty();
+
+    bool insert(const value_type &value);
+
+    size_t remove(const key_type &key);
+
+    bool contains(const key_type &key) const;
+
+    size_t lookup_loads(const key_type &key) const;
+
+    void rehash(size_type count);
+
+    void reserve(size_type count);
+
+    std::vector<Key> keys() const;
+
+    template<class Fn>
+    void for_each(Fn fn) const;
+
+    hash hash_function() const;
+};
+
+//-------------------------------------------------------
+// Name: Default Constructor
+// Initializes an empty table with 11 buckets, which aren't allocated until the first insert
+//---------------------------------------------------------
+template<class Key, class Hash>
+InlineHashTable<Key, Hash>::InlineHashTable() {
+    bucketCount = 11;
+    currentSize = 0;
+    overflowCount = 0;
+    maxLoad = 1;
+}
+
+//-------------------------------------------------------
+// Name: Copy Constructor
+// Copies other's keys into a table of the same size, bucket by bucket
+//---------------------------------------------------------
+template<class Key, class Hash>
+InlineHashTable<Key, Hash>::InlineHashTable(const InlineHashTable &other) : InlineHashTable() {
+    *this = other;
+}
+
+//-------------------------------------------------------
+// Name: Equals operator
+// Replaces our keys with copies of other's, keeping its size, load factor and hasher. The cached
+// hashes come along too, so the copy never calls the hasher.
+//---------------------------------------------------------
+template<class Key, class Hash>
+InlineHashTable<Key, Hash> &InlineHashTable<Key, Hash>::operator=(const InlineHashTable &other) {
+
+    // Check for self assignment
+    if (this == &other) {
+        return *this;
+    }
+
+    release();
+    bucketCount = other.bucketCount;
+    maxLoad = other.maxLoad;
+    hasher = other.hasher;
+    if (!other.buckets.empty()) {
+        std::vector<slot> table(bucketCount);
+        for (const slot &bucket : other.buckets) {
+            if (bucket.occupied) {
+                place(table, Key(*bucket.key()), bucket.hashCode);
+            }
+            for (const overflowNode *current = bucket.next; current != nullptr; current = current->next) {
+                place(table, Key(current->key), current->hashCode);
+            }
+        }
+        buckets = std::move(table);
+    }
+    currentSize = other.currentSize;
+    return *this;
+}
+
+//-------------------------------------------------------
+// Name: Destructor
+// Destroys every inline key and frees the overflow nodes, the vector frees the rest
+//---------------------------------------------------------
+template<class Key, class Hash>
+InlineHashTable<Key, Hash>::~InlineHashTable() {
+    release();
+}
+
+//-------------------------------------------------------
+// Name: Parameterized Constructor
+// Initializes a table with the given number of buckets, allocated right away
+//---------------------------------------------------------
+template<class Key, class Hash>
+InlineHashTable<Key, Hash>::InlineHashTable(size_type buckets) : InlineHashTable() {
+    bucketCount = std::max<size_t>(1, buckets);
+    this->buckets = std::vector<slot>(bucketCount);
+}
+
+//-------------------------------------------------------
+// Name: Presizing Constructor
+// Initializes a table that is about to receive count keys, sized so none of them cause a rehash
+//---------------------------------------------------------
+template<class Key, class Hash>
+InlineHashTable<Key, Hash>::InlineHashTable(expected_size_t, size_type count) : InlineHashTable() {
+    reserve(count);
+}
+
+//-------------------------------------------------------
+// Name: is_empty
+// Returns true or false depending on whether the table is empty or not
+//---------------------------------------------------------
+template<class Key, class Hash>
+bool InlineHashTable<Key, Hash>::is_empty() const {
+    return currentSize == 0;
+}
+
+//-------------------------------------------------------
+// Name: size
+// Returns the number of keys in the table
+//---------------------------------------------------------
+template<class Key, class Hash>
+size_t InlineHashTable<Key, Hash>::size() const {
+    return currentSize;
+}
+
+//-------------------------------------------------------
+// Name: bucket_count
+// Returns the number of buckets
+//---------------------------------------------------------
+template<class Key, class Hash>
+size_t InlineHashTable<Key, Hash>::bucket_count() const {
+    return bucketCount;
+}
+
+//-------------------------------------------------------
+// Name: bucket_size
+// Returns the number of keys in bucket n, the inline one included
+//---------------------------------------------------------
+template<class Key, class Hash>
+size_t InlineHashTable<Key, Hash>::bucket_size(size_t n) const {
+
+    if (buckets.empty() || !buckets[n].occupied) {
+        return 0;
+    }
+
+    size_t keys = 1;
+    for (const overflowNode *current = buckets[n].next; current != nullptr; current = current->next) {
+        keys += 1;
+    }
+    return keys;
+}
+
+//-------------------------------------------------------
+// Name: overflow_nodes
+// Returns how many keys didn't fit inline and live in a node of their own
+//---------------------------------------------------------
+template<class Key, class Hash>
+size_t InlineHashTable<Key, Hash>::overflow_nodes() const {
+    return overflowCount;
+}
+
+//-------------------------------------------------------
+// Name: load_factor
+// Returns the average number of keys per bucket
+//---------------------------------------------------------
+template<class Key, class Hash>
+float InlineHashTable<Key, Hash>::load_factor() const {
+    return float(currentSize) / float(bucketCount);
+}
+
+//-------------------------------------------------------
+// Name: max_load_factor
+// Returns the load factor past which the table doubles its buckets
+//---------------------------------------------------------
+template<class Key, class Hash>
+float InlineHashTable<Key, Hash>::max_load_factor() const {
+    return maxLoad;
+}
+
+//-------------------------------------------------------
+// Name: max_load_factor
+// Sets a new max load factor, rehashing right away if the table is already over it. The higher it
+// goes the more keys end up in overflow nodes, costing a load each just like the list layout.
+//---------------------------------------------------------
+template<class Key, class Hash>
+void InlineHashTable<Key, Hash>::max_load_factor(float mlf) {
+    maxLoad = mlf;
+    if (load_factor() > maxLoad) {
+        reserve(currentSize);
+    }
+}
+
+//-------------------------------------------------------
+// Name: make_empty
+// Removes every key and frees the overflow nodes, keeping the bucket count
+//---------------------------------------------------------
+template<class Key, class Hash>
+void InlineHashTable<Key, Hash>::make_empty() {
+    if (buckets.empty()) {
+        return;
+    }
+    release();
+    buckets = std::vector<slot>(bucketCount);
+}
+
+//-------------------------------------------------------
+// Name: insert
+// Adds the key if it isn't there yet, inline if its bucket is empty and in a new node otherwise,
+// and doubles the buckets once the load factor goes over the max
+//---------------------------------------------------------
+template<class Key, class Hash>
+bool InlineHashTable<Key, Hash>::insert(const value_type &value) {
+
+    if (buckets.empty()) {
+        buckets = std::vector<slot>(bucketCount);
+    }
+
+    size_t hashCode = hasher(value);
+    if (findKey(value, hashCode) != nullptr) {
+        return false;
+    }
+
+    place(buckets, Key(value), hashCode);
+    currentSize += 1;
+    if (load_factor() > maxLoad) {
+        rehash(HashPrimes::nextPrime(bucketCount * 2));
+    }
+    return true;
+}
+
+//-------------------------------------------------------
+// Name: remove
+// Removes the key if it's there. Removing the inline key moves the bucket's first overflow key
+// into the array in its place, so a bucket with any keys always has one inline.
+//---------------------------------------------------------
+template<class Key, class Hash>
+size_t InlineHashTable<Key, Hash>::remove(const key_type &key) {
+
+    if (currentSize == 0) {
+        return 0;
+    }
+
+    size_t hashCode = hasher(key);
+    slot &bucket = buckets[homeIndex(hashCode, bucketCount)];
+    if (!bucket.occupied) {
+        return 0;
+    }
+
+    if (bucket.hashCode == hashCode && *bucket.key() == key) {
+        overflowNode *first = bucket.next;
+        if (first == nullptr) {
+            bucket.key()->~Key();
+            bucket.occupied = false;
+        } else {
+            *bucket.key() = std::move(first->key);
+            bucket.hashCode = first->hashCode;
+            bucket.next = first->next;
+            delete first;
+            overflowCount -= 1;
+        }
+        currentSize -= 1;
+        return 1;
+    }
+
+    for (overflowNode **link = &bucket.next; *link != nullptr; link = &(*link)->next) {
+        overflowNode *current = *link;
+        if (current->hashCode == hashCode && current->key == key) {
+            *link = current->next;
+            delete current;
+            overflowCount -= 1;
+            currentSize -= 1;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+//-------------------------------------------------------
+// Name: contains
+// Returns true or false depending on whether the key is in the table
+//---------------------------------------------------------
+template<class Key, class Hash>
+bool InlineHashTable<Key, Hash>::contains(const key_type &key) const {
+    return currentSize != 0 && findKey(key, hasher(key)) != nullptr;
+}
+
+//-------------------------------------------------------
+// Name: lookup_loads
+// Returns how many dependent loads a lookup of the key takes: one for its slot in the bucket
+// array, then one per overflow node up to the one holding it, or all of them if it isn't there
+//---------------------------------------------------------
+template<class Key, class Hash>
+size_t InlineHashTable<Key, Hash>::lookup_loads(const key_type &key) const {
+
+    if (buckets.empty()) {
+        return 0;
+    }
+
+    size_t hashCode = hasher(key);
+    const slot &bucket = buckets[homeIndex(hashCode, bucketCount)];
+    size_t loads = 1;
+    if (!bucket.occupied || (bucket.hashCode == hashCode && *bucket.key() == key)) {
+        return loads;
+    }
+    for (const overflowNode *current = bucket.next; current != nullptr; current = current->next) {
+        loads += 1;
+        if (current->hashCode == hashCode && current->key == key) {
+            break;
+        }
+    }
+    return loads;
+}
+
+//-------------------------------------------------------
+// Name: rehash
+// Moves every key into a new array of count buckets using the cached hashes. Overflow nodes are
+// relinked rather than copied whenever their new bucket already has an inline key.
+//---------------------------------------------------------
+template<class Key, class Hash>
+void InlineHashTable<Key, Hash>::rehash(size_type count) {
+
+    size_t keys = currentSize;
+    bucketCount = std::max<size_t>(1, count);
+    std::vector<slot> table(bucketCount);
+    size_t nodes = 0;
+    for (slot &bucket : buckets) {
+        overflowNode *current = bucket.next;
+        bucket.next = nullptr;
+        if (bucket.occupied) {
+            slot &target = table[homeIndex(bucket.hashCode, bucketCount)];
+            if (target.occupied) {
+                target.next = new overflowNode{target.next, bucket.hashCode, std::move(*bucket.key())};
+                nodes += 1;
+            } else {
+                new (target.storage) Key(std::move(*bucket.key()));
+                target.hashCode = bucket.hashCode;
+                target.occupied = true;
+            }
+        }
+        while (current != nullptr) {
+            overflowNode *next = current->next;
+            slot &target = table[homeIndex(current->hashCode, bucketCount)];
+            if (target.occupied) {
+                current->next = target.next;
+                target.next = current;
+                nodes += 1;
+            } else {
+                new (target.storage) Key(std::move(current->key));
+                target.hashCode = current->hashCode;
+                target.occupied = true;
+                delete current;
+            }
+            current = next;
+        }
+    }
+
+    // The old slots only hold moved-from keys now, and none of them have nodes left
+    release();
+    overflowCount = nodes;
+    buckets = std::move(table);
+    currentSize = keys;
+}
+
+//-------------------------------------------------------
+// Name: reserve
+// Makes room for count keys under the current max load factor, so inserting that many never
+// triggers a rehash. It never shrinks the table.
+//---------------------------------------------------------
+template<class Key, class Hash>
+void InlineHashTable<Key, Hash>::reserve(size_type count) {
+    size_t needed = HashPrimes::nextPrime(size_t(float(count) / maxLoad) + 1);
+    if (needed > bucketCount || buckets.empty()) {
+        rehash(std::max(needed, bucketCount));
+    }
+}
+
+//-------------------------------------------------------
+// Name: keys
+// Collects every key into a single vector
+//---------------------------------------------------------
+template<class Key, class Hash>
+std::vector<Key> InlineHashTable<Key, Hash>::keys() const {
+    std::vector<Key> result;
+    result.reserve(currentSize);
+    for_each([&result](const Key &key) {
+        result.push_back(key);
+    });
+    return result;
+}
+
+//-------------------------------------------------------
+// Name: for_each
+// Calls fn on every key, bucket by bucket, the inline key first
+//---------------------------------------------------------
+template<class Key, class Hash>
+template<class Fn>
+void InlineHashTable<Key, Hash>::for_each(Fn fn) const {
+    for (const slot &bucket : buckets) {
+        if (!bucket.occupied) {
+            continue;
+        }
+        fn(*bucket.key());
+        for (const overflowNode *current = bucket.next; current != nullptr; current = current->next) {
+            fn(current->key);
+        }
+    }
+}
+
+//-------------------------------------------------------
+// Name: hash_function
+// Returns a copy of the table's hasher
+//---------------------------------------------------------
+template<class Key, class Hash>
+typename InlineHashTable<Key, Hash>::hash InlineHashTable<Key, Hash>::hash_function() const {
+    return hasher;
+}
+
+//-------------------------------------------------------
+// Name: findKey
+// Checks the key's slot and then its overflow nodes, only comparing keys whose cached hash
+// matches. Returns the key in the table, or nullptr if it isn't there.
+//---------------------------------------------------------
+template<class Key, class Hash>
+const Key *InlineHashTable<Key, Hash>::findKey(const key_type &key, size_t hashCode) const {
+
+    const slot &bucket = buckets[homeIndex(hashCode, bucketCount)];
+    if (!bucket.occupied) {
+        return nullptr;
+    }
+    if (bucket.hashCode == hashCode && *bucket.key() == key) {
+        return bucket.key();
+    }
+    for (const overflowNode *current = bucket.next; current != nullptr; current = current->next) {
+        if (current->hashCode == hashCode && current->key == key) {
+            return &current->key;
+        }
+    }
+    return nullptr;
+}
+
+//-------------------------------------------------------
+// Name: place
+// Moves a key into its bucket in table, inline if the bucket is empty and in a new node at the
+// front of its overflow chain otherwise. It doesn't check for duplicates or count the key.
+//---------------------------------------------------------
+template<class Key, class Hash>
+void InlineHashTable<Key, Hash>::place(std::vector<slot> &table, Key &&key, size_t hashCode) {
+
+    slot &bucket = table[homeIndex(hashCode, table.size())];
+    if (!bucket.occupied) {
+        new (bucket.storage) Key(std::move(key));
+        bucket.hashCode = hashCode;
+        bucket.occupied = true;
+        return;
+    }
+    bucket.next = new overflowNode{bucket.next, hashCode, std::move(key)};
+    overflowCount += 1;
+}
+
+//-------------------------------------------------------
+// Name: release
+// Destroys every inline key and frees every overflow node, leaving the table with no buckets at all
+//---------------------------------------------------------
+template<class Key, class Hash>
+void InlineHashTable<Key, Hash>::release() {
+    for (slot &bucket : buckets) {
+        if (bucket.occupied) {
+            bucket.key()->~Key();
+        }
+        overflowNode *current = bucket.next;
+        while (current != nullptr) {
+            overflowNode *next = current->next;
+            delete current;
+            current = next;
+        }
+    }
+    buckets.clear();
+    currentSize = 0;
+    overflowCount = 0;
+}
+
+#endif  // HASHTABLE_INLINE_H
@@ -15,9 +15,23 @@
 #ifndef HASHTABLE_OPEN_ADDRESSING_H
 #define HASHTABLE_OPEN_ADDRESSING_H
 
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <iostream>
+#include <iterator>
+#include <mutex>
 #include <vector>
+#include "hashtable_frozen.h"
+#include "hashtable_hash.h"
+#include "hashtable_primes.h"
+#include "hashtable_batch.h"
+#include "hashtable_parallel.h"
+#include "hashtable_pool.h"
 
 template<class Key, class Hash=std::hash<Key>>
 class HashTable {
@@ -31,8 +45,9 @@ public:
 
 private:
     struct cell {
-        // Three states a cell can be, 0 = empty, 1 = occupied, 2= deleted
-        int state;
+        // Three states a cell can be, 0 = empty, 1 = occupied, 2= deleted. The state sits in the
+        // low two bits, and the rest hold the generation it was written in (see stateOf)
+        unsigned int state;
         // Store the information from the key
         Key data;
 
@@ -44,20 +59,118 @@ private:
 
     int cellCount;
     int currentSize;
+    // Deleted cells still lengthen probe sequences until a rehash clears them, so they count
+    // toward the load that triggers one
+    int deletedCount;
     float maxLoad;
+    // Removing keys until the load factor drops under minLoad shrinks the table, but never below
+    // minCells (the size asked for at construction or by reserve). Shrinking aims for half of
+    // maxLoad, so the table has to grow or shrink a lot before it resizes again.
+    float minLoad;
+    int minCells;
+    // With lazyClear on, make_empty just bumps generation, so every cell written before it reads as
+    // empty again. With it off (the default) generation stays 0 and make_empty marks every cell.
+    bool lazyClear;
+    unsigned int generation;
+    // The furthest any key has been probed from its home cell (counting forward with wraparound)
+    // since the last rehash or make_empty, so scan knows how far past a cell its keys can be
+    int maxDisplacement;
+    // Stays an empty vector (which doesn't allocate) until the first insert, cellCount is still 11
     std::vector<cell> table;
+    // Our own copy of the hasher, so a seeded hasher gets a different seed in every table
+    Hash hasher;
 
     bool isActive(int index);
 
+    void allocateTable();
+
+    int stateOf(const cell &c) const;
+
+    void setState(cell &c, int state);
+
+    void copyCells(const HashTable &other);
+
+    void noteDisplacement(size_t home, size_t index);
+
     void rehash(size_type count);
 
+    void rehashInParallel(const std::vector<cell> &oldTable, size_t oldDisplacement);
+
     float loadFactor() const;
 
-    bool isPrime(int count);
+    void shrinkIfSparse();
+
+    void growFor(size_t count);
 
-    int nextPrime(int count);
+    template<class K>
+    size_t findPosition(const K &key) const;
+
+    template<class K>
+    size_t probeFrom(const K &key, size_t home) const;
+
+    template<class K>
+    bool containsKey(const K &key) const;
+
+    std::vector<size_t> findShared(const HashTable &other, WorkStealingPool &pool) const;
+
+    template<class Drop>
+    void removeCells(Drop drop, WorkStealingPool &pool);
+
+    // How many keys insert_many / contains_many hash at a time, and how many keys ahead of the
+    // one being probed they prefetch
+    static constexpr size_t batchSize = 256;
+    static constexpr size_t prefetchDistance = 16;
+    // Tables with at least this many cells rehash on the shared work-stealing pool, and each task
+    // fills a region of at least regionCells new cells
+    static constexpr size_t parallelRehashThreshold = size_t(1) << 16;
+    static constexpr size_t regionCells = size_t(1) << 14;
 
 public:
+    // Forward iterator over every occupied cell, in cell order. Keys can't be changed in place,
+    // since that would break their probe sequence, so iterator and const_iterator are the same type.
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Key;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Key *;
+        using reference = const Key &;
+
+        const_iterator() : owner(nullptr), index(0) {}
+
+        reference operator*() const { return owner->table[index].data; }
+
+        pointer operator->() const { return &owner->table[index].data; }
+
+        const_iterator &operator++() {
+            index += 1;
+            skipInactiveCells();
+            return *this;
+        }
+
+        const_iterator operator++(int) {
+            const_iterator old = *this;
+            ++*this;
+            return old;
+        }
+
+        bool operator==(const const_iterator &other) const { return index == other.index; }
+
+        bool operator!=(const const_iterator &other) const { return index != other.index; }
+
+    private:
+        friend class HashTable;
+
+        const HashTable *owner;
+        size_t index;
+
+        const_iterator(const HashTable *table, size_t start);
+
+        void skipInactiveCells();
+    };
+
+    using iterator = const_iterator;
+
     HashTable();
 
     HashTable(const HashTable &other);
@@ -68,6 +181,8 @@ public:
 
     HashTable(size_type cells);
 
+    HashTable(expected_size_t, size_type count);
+
     bool is_empty() const;
 
     size_t size() const;
@@ -78,14 +193,77 @@ public:
 
     bool insert(const value_type &value);
 
+    template<class InputIt>
+    void insert(InputIt first, InputIt last);
+
+    void reserve(size_type count);
+
+    void shrink_to_fit();
+
+    float min_load_factor() const;
+
+    void min_load_factor(float mlf);
+
+    bool lazy_clear() const;
+
+    void lazy_clear(bool enabled);
+
     size_t remove(const key_type &key);
 
     bool contains(const key_type &key);
 
     size_t position(const key_type &key) const;
 
+    // Transparent overloads, only available when Hash defines is_transparent (e.g. StringHash),
+    // so a HashTable<std::string, StringHash> can be searched with a string_view or const char*
+    template<class K, class H = Hash, class = typename H::is_transparent>
+    size_t remove(const K &key);
+
+    template<class K, class H = Hash, class = typename H::is_transparent>
+    bool contains(const K &key);
+
+    template<class K, class H = Hash, class = typename H::is_transparent>
+    size_t position(const K &key) const;
+
     void print_table(std::ostream &os = std::cout) const;
 
+    std::vector<Key> keys() const;
+
+    const_iterator begin() const;
+
+    const_iterator end() const;
+
+    template<class Fn>
+    void for_each(Fn fn) const;
+
+    template<class Fn>
+    void parallel_for_each(Fn fn, WorkStealingPool &pool = WorkStealingPool::shared()) const;
+
+    template<class Pred>
+    size_t parallel_count_if(Pred pred, WorkStealingPool &pool = WorkStealingPool::shared()) const;
+
+    template<class Fn>
+    uint64_t scan(uint64_t cursor, size_t count, Fn fn) const;
+
+    size_t insert_many(const key_type *keys, size_t count);
+
+    void contains_many(const key_type *keys, size_t count, bool *results) const;
+
+    hash hash_function() const;
+
+    template<class RandomIt>
+    void build(RandomIt first, RandomIt last, unsigned threads = defaultThreadCount());
+
+    FrozenHashTable<Key, Hash> freeze() const;
+
+    void union_with(const HashTable &other);
+
+    void intersect_with(const HashTable &other, WorkStealingPool &pool = WorkStealingPool::shared());
+
+    void difference_with(const HashTable &other, WorkStealingPool &pool = WorkStealingPool::shared());
+
+    bool is_subset_of(const HashTable &other, WorkStealingPool &pool = WorkStealingPool::shared()) const;
+
     // Optional
     // HashTable(HashTable&& other);
     // HashTable& operator=(HashTable&& other);
@@ -94,20 +272,22 @@ public:
 
 //-------------------------------------------------------
 // Name: Default Constructor
-// Initializes a new hashtable
+// Initializes a new hashtable. The cells aren't allocated until the first insert, so a table
+// that never gets used costs nothing.
 //---------------------------------------------------------
 template<class Key, class Hash>
 HashTable<Key, Hash>::HashTable() {
-    // Initialize our default values and create the hash table
+    // Initialize our default values, the cells come later
     cellCount = 11;
     currentSize = 0;
+    deletedCount = 0;
     maxLoad = 0.5;
+    minLoad = 0.125;
+    minCells = cellCount;
+    lazyClear = false;
+    generation = 0;
+    maxDisplacement = 0;
     table = std::vector<cell>();
-
-    // Occupy the table with empty cells
-    for (int i = 0; i < cellCount; i++) {
-        table.push_back(cell());
-    }
 }
 
 //-------------------------------------------------------
@@ -117,26 +297,19 @@ HashTable<Key, Hash>::HashTable() {
 template<class Key, class Hash>
 HashTable<Key, Hash>::HashTable(const HashTable &other) {
 
-    // Copy the variables over
+    // Copy the variables over, including the hasher since the positions depend on its seed
     cellCount = other.cellCount;
     maxLoad = other.maxLoad;
+    minLoad = other.minLoad;
+    minCells = other.minCells;
+    lazyClear = other.lazyClear;
+    maxDisplacement = other.maxDisplacement;
     currentSize = other.currentSize;
-    table = std::vector<cell>();
-
-    for (int i = 0; i < cellCount; i++) {
-        table.push_back(cell());
-    }
+    deletedCount = other.deletedCount;
+    hasher = other.hasher;
 
-    // No further action required if the other table is empty
-    if (!other.is_empty()) {
-        // Copy the values over
-        for (int i = 0; i < other.cellCount; i++) {
-            cell tmpCell;
-            tmpCell.data = other.table.at(i).data;
-            tmpCell.state = other.table.at(i).state;
-            table.push_back(tmpCell);
-        }
-    }
+    // Copy the cells over in place, so every key stays at the position it probes to
+    copyCells(other);
 }
 
 //-------------------------------------------------------
@@ -161,9 +334,14 @@ HashTable<Key, Hash> &HashTable<Key, Hash>::operator=(const HashTable &other) {
     // Copy the variables over
     cellCount = other.cellCount;
     maxLoad = other.maxLoad;
+    minLoad = other.minLoad;
+    minCells = other.minCells;
+    lazyClear = other.lazyClear;
+    maxDisplacement = other.maxDisplacement;
     currentSize = other.currentSize;
-    table = std::vector<cell>(cellCount);
-    table = other.table;
+    deletedCount = other.deletedCount;
+    hasher = other.hasher;
+    copyCells(other);
 
     return *this;
 }
@@ -178,11 +356,27 @@ HashTable<Key, Hash>::HashTable(HashTable::size_type cells) {
     // Set our cell size and initialize the other variables
     cellCount = cells;
     currentSize = 0;
+    deletedCount = 0;
     maxLoad = 0.5;
+    minLoad = 0.125;
+    minCells = cellCount;
+    lazyClear = false;
+    generation = 0;
+    maxDisplacement = 0;
     table = std::vector<cell>(cellCount);
 
 }
 
+//-------------------------------------------------------
+// Name: Expected Size Constructor
+// Initializes a hashtable that is about to receive count keys, with enough cells that none of
+// them cause a rehash
+//---------------------------------------------------------
+template<class Key, class Hash>
+HashTable<Key, Hash>::HashTable(expected_size_t, HashTable::size_type count) : HashTable() {
+    reserve(count);
+}
+
 //-------------------------------------------------------
 // Name: is_empty
 // Returns true or false depending on whether the hashtable is empty or not
@@ -219,16 +413,80 @@ size_t HashTable<Key, Hash>::table_size() const {
 
 //-------------------------------------------------------
 // Name: make_empty()
-// Sets all of the cells in the hashtable to empty
+// Sets all of the cells in the hashtable to empty. With lazy_clear on this takes constant time,
+// starting a new generation makes every cell stamped with an older one read as empty.
 //---------------------------------------------------------
 template<class Key, class Hash>
 void HashTable<Key, Hash>::make_empty() {
 
-    // Mark all cells as empty
+    currentSize = 0;
+    deletedCount = 0;
+    maxDisplacement = 0;
+
+    // Mark every cell for real unless we're lazy, or once the generation is about to run out of bits
+    if (!lazyClear || generation == (UINT_MAX >> 2)) {
+        for (unsigned int i = 0; i < table.size(); i++) {
+            table.at(i).state = 0;
+        }
+        generation = 0;
+        return;
+    }
+    generation += 1;
+}
+
+//-------------------------------------------------------
+// Name: stateOf
+// The cell's state in the current generation, a cell left over from before make_empty is empty
+//---------------------------------------------------------
+template<class Key, class Hash>
+int HashTable<Key, Hash>::stateOf(const cell &c) const {
+    if ((c.state >> 2) != generation) {
+        return 0;
+    }
+    return int(c.state & 3);
+}
+
+//-------------------------------------------------------
+// Name: setState
+// Gives a cell a new state, stamped with the current generation
+//---------------------------------------------------------
+template<class Key, class Hash>
+void HashTable<Key, Hash>::setState(cell &c, int state) {
+    c.state = (generation << 2) | unsigned(state);
+}
+
+//-------------------------------------------------------
+// Name: copyCells
+// Copies other's cells into the same positions. Cells from an older generation are copied as
+// empty cells rather than with their old keys, and the copy starts over in generation 0.
+//---------------------------------------------------------
+template<class Key, class Hash>
+void HashTable<Key, Hash>::copyCells(const HashTable &other) {
+
+    generation = 0;
+    if (other.generation == 0) {
+        table = other.table;
+        return;
+    }
+
+    table = std::vector<cell>(other.table.size());
     for (unsigned int i = 0; i < table.size(); i++) {
-        table.at(i).state = 0;
+        int state = other.stateOf(other.table[i]);
+        if (state == 1) {
+            table[i].data = other.table[i].data;
+        }
+        setState(table[i], state);
     }
-    currentSize = 0;
+}
+
+//-------------------------------------------------------
+// Name: noteDisplacement
+// Records how far a key just placed at index ended up from its home cell
+//---------------------------------------------------------
+template<class Key, class Hash>
+void HashTable<Key, Hash>::noteDisplacement(size_t home, size_t index) {
+    size_t distance = index >= home ? index - home : index + size_t(cellCount) - home;
+    maxDisplacement = std::max(maxDisplacement, int(distance));
 }
 
 //-------------------------------------------------------
@@ -238,8 +496,11 @@ void HashTable<Key, Hash>::make_empty() {
 template<class Key, class Hash>
 bool HashTable<Key, Hash>::insert(const value_type &value) {
 
+    allocateTable();
+
     // Get the index we should insert to
-    int currentIndex = position(value);
+    size_t home = homeIndex(hasher(value), cellCount);
+    int currentIndex = probeFrom(value, home);
 
     // Check if the cell is active, because we can't insert duplicates
     if (isActive(currentIndex)) {
@@ -248,16 +509,159 @@ bool HashTable<Key, Hash>::insert(const value_type &value) {
 
     // Update the cell's data and state
     table.at(currentIndex).data = value;
-    table.at(currentIndex).state = 1;
+    setState(table.at(currentIndex), 1);
+    noteDisplacement(home, currentIndex);
     currentSize += 1;
 
     if (loadFactor() > maxLoad) {
         rehash(cellCount * 2);
+    } else if (float(currentSize + deletedCount) / float(cellCount) > maxLoad) {
+        // Mostly deleted cells, so clearing them out is enough
+        rehash(cellCount);
     }
 
     return true;
 }
 
+//-------------------------------------------------------
+// Name: insert (range)
+// Inserts every key in [first, last). When the length of the range can be found without
+// consuming it, the table is grown once up front instead of doubling repeatedly along the way.
+//---------------------------------------------------------
+template<class Key, class Hash>
+template<class InputIt>
+void HashTable<Key, Hash>::insert(InputIt first, InputIt last) {
+
+    using category = typename std::iterator_traits<InputIt>::iterator_category;
+    if constexpr (std::is_base_of_v<std::forward_iterator_tag, category>) {
+        growFor(size_t(currentSize) + size_t(std::distance(first, last)));
+    }
+    for (; first != last; ++first) {
+        insert(*first);
+    }
+}
+
+//-------------------------------------------------------
+// Name: reserve
+// Makes room for count keys under the current max load factor, so inserting that many never
+// triggers a rehash. It never shrinks the table, and removing keys won't shrink it below this
+// size either until shrink_to_fit.
+//---------------------------------------------------------
+template<class Key, class Hash>
+void HashTable<Key, Hash>::reserve(HashTable::size_type count) {
+    growFor(count);
+    minCells = int(std::max<size_t>(minCells, size_t(std::ceil(float(count) / maxLoad))));
+}
+
+//-------------------------------------------------------
+// Name: growFor
+// Grows the table so count keys fit under the max load factor. Bulk inserts presize with this
+// rather than reserve, so the table can still shrink once their keys are removed again.
+//---------------------------------------------------------
+template<class Key, class Hash>
+void HashTable<Key, Hash>::growFor(size_t count) {
+
+    // insert rehashes once the load factor goes over maxLoad, so stay at or under it
+    size_t needed = size_t(std::ceil(float(count) / maxLoad));
+    if (needed > size_t(cellCount)) {
+        rehash(needed);
+    }
+}
+
+//-------------------------------------------------------
+// Name: shrink_to_fit
+// Shrinks the table to the fewest cells that hold its keys under the max load factor, which also
+// clears out every deleted cell. Unlike automatic shrinking this gives back what reserve asked for,
+// and the smaller size becomes the new floor. It never grows the table, and a table that hasn't
+// allocated yet only changes the cell count it will allocate with.
+//---------------------------------------------------------
+template<class Key, class Hash>
+void HashTable<Key, Hash>::shrink_to_fit() {
+
+    int target = int(HashPrimes::nextPrime(std::max<size_t>(1, size_t(std::ceil(float(currentSize) / maxLoad)))));
+    if (target >= cellCount) {
+        // Already as small as it gets, but rebuilding at the same size still drops the deleted cells
+        minCells = std::min(minCells, cellCount);
+        target = cellCount;
+        if (deletedCount == 0) {
+            return;
+        }
+    } else {
+        minCells = target;
+    }
+
+    if (table.empty()) {
+        cellCount = target;
+        return;
+    }
+    rehash(size_t(target));
+}
+
+//-------------------------------------------------------
+// Name: min_load_factor
+// Returns the load factor under which removing keys shrinks the table
+//---------------------------------------------------------
+template<class Key, class Hash>
+float HashTable<Key, Hash>::min_load_factor() const {
+    return minLoad;
+}
+
+//-------------------------------------------------------
+// Name: min_load_factor
+// Sets a new minimum load factor, 0 turns automatic shrinking off. It should stay well under half
+// of the max load factor, or the table would shrink straight back to the same size.
+//---------------------------------------------------------
+template<class Key, class Hash>
+void HashTable<Key, Hash>::min_load_factor(float mlf) {
+    minLoad = mlf;
+    shrinkIfSparse();
+}
+
+//-------------------------------------------------------
+// Name: lazy_clear
+// Returns whether make_empty leaves the old cells to be ignored instead of marking them empty
+//---------------------------------------------------------
+template<class Key, class Hash>
+bool HashTable<Key, Hash>::lazy_clear() const {
+    return lazyClear;
+}
+
+//-------------------------------------------------------
+// Name: lazy_clear
+// Turns lazy clearing on or off. Lazy clearing makes make_empty constant time, which pays off for
+// a big table that's refilled with a few keys and emptied over and over. Turning it off marks the
+// cells left over from older generations as empty for real.
+//---------------------------------------------------------
+template<class Key, class Hash>
+void HashTable<Key, Hash>::lazy_clear(bool enabled) {
+
+    if (!enabled && generation != 0) {
+        for (unsigned int i = 0; i < table.size(); i++) {
+            table[i].state = unsigned(stateOf(table[i]));
+        }
+        generation = 0;
+    }
+    lazyClear = enabled;
+}
+
+//-------------------------------------------------------
+// Name: shrinkIfSparse
+// Shrinks the table once enough keys have been removed that the load factor is under minLoad
+//---------------------------------------------------------
+template<class Key, class Hash>
+void HashTable<Key, Hash>::shrinkIfSparse() {
+
+    if (loadFactor() >= minLoad || cellCount <= minCells) {
+        return;
+    }
+
+    // Land halfway to the max load factor, so a few inserts don't immediately grow it back
+    int target = int(HashPrimes::nextPrime(std::max<size_t>(minCells, size_t(float(currentSize) / (maxLoad / 2)))));
+    if (target < cellCount) {
+        rehash(target);
+    }
+}
+
 
 //-------------------------------------------------------
 // Name: remove
@@ -266,6 +670,11 @@ bool HashTable<Key, Hash>::insert(const value_type &value) {
 template<class Key, class Hash>
 size_t HashTable<Key, Hash>::remove(const key_type &key) {
 
+    // Nothing to remove, and the cells might not even be allocated yet
+    if (is_empty()) {
+        return 0;
+    }
+
     // Check to ensure the element isn't already deleted / not present
     int currentIndex = position(key);
     if (!isActive(currentIndex)) {
@@ -273,13 +682,39 @@ size_t HashTable<Key, Hash>::remove(const key_type &key) {
     }
 
     // Set the cell's state to deleted
-    table.at(currentIndex).state = 2;
+    setState(table.at(currentIndex), 2);
     currentSize -= 1;
+    deletedCount += 1;
+    shrinkIfSparse();
 
     // Return 1, since we've removed one element
     return 1;
 }
 
+//-------------------------------------------------------
+// Name: remove (transparent)
+// Same as remove, but the key only has to be hashable by Hash and comparable with Key
+//---------------------------------------------------------
+template<class Key, class Hash>
+template<class K, class H, class>
+size_t HashTable<Key, Hash>::remove(const K &key) {
+
+    if (is_empty()) {
+        return 0;
+    }
+
+    int currentIndex = findPosition(key);
+    if (!isActive(currentIndex)) {
+        return 0;
+    }
+
+    setState(table.at(currentIndex), 2);
+    currentSize -= 1;
+    deletedCount += 1;
+    shrinkIfSparse();
+    return 1;
+}
+
 
 //-------------------------------------------------------
 // Name: contains
@@ -291,18 +726,36 @@ bool HashTable<Key, Hash>::contains(const key_type &key) {
     if (is_empty()) {
         return false;
     }
-    // Iterate through the table to find the index of the given key, and check if it's active
-    for (unsigned int i = 0; i < table.size(); i++) {
-        // If we've found the data, we need to check if it's active or not
-        if (table.at(i).state == 1 && table.at(i).data == key) {
-            return true;
-        }
-    }
+    // Follow the key's probe sequence instead of scanning the whole table
+    return isActive(position(key));
+}
+
+//-------------------------------------------------------
+// Name: contains (transparent)
+// Same as contains, but the key only has to be hashable by Hash and comparable with Key
+//---------------------------------------------------------
+template<class Key, class Hash>
+template<class K, class H, class>
+bool HashTable<Key, Hash>::contains(const K &key) {
 
-    return false;
+    if (is_empty()) {
+        return false;
+    }
+    return isActive(findPosition(key));
 }
 
 
+//-------------------------------------------------------
+// Name: allocateTable
+// Gives a table that hasn't been used yet its cells
+//---------------------------------------------------------
+template<class Key, class Hash>
+void HashTable<Key, Hash>::allocateTable() {
+    if (table.empty()) {
+        table = std::vector<cell>(cellCount);
+    }
+}
+
 //-------------------------------------------------------
 // Name: isActive
 // Returns true or false depending on whether the given cell is active or not
@@ -311,7 +764,7 @@ template<class Key, class Hash>
 bool HashTable<Key, Hash>::isActive(int index) {
 
     // Check if the given cell is active, and return true or false accordingly
-    if (table.at(index).state != 1) {
+    if (stateOf(table.at(index)) != 1) {
         return false;
     }
 
@@ -325,24 +778,47 @@ bool HashTable<Key, Hash>::isActive(int index) {
 //---------------------------------------------------------
 template<class Key, class Hash>
 size_t HashTable<Key, Hash>::position(const key_type &key) const {
+    return findPosition(key);
+}
 
-    int offset = 1;
-    size_t hashVal = Hash{}(key);
-    hashVal = hashVal % cellCount;
-
-    size_t currentIndex = hashVal;
+//-------------------------------------------------------
+// Name: position (transparent)
+// Same as position, but the key only has to be hashable by Hash and comparable with Key
+//---------------------------------------------------------
+template<class Key, class Hash>
+template<class K, class H, class>
+size_t HashTable<Key, Hash>::position(const K &key) const {
+    return findPosition(key);
+}
 
-    // Check to ensure the currentIndex isn't empty, nor does it contain the value we're looking to insert
-    while (table.at(currentIndex).state != 0 && table.at(currentIndex).data != key) {
-        currentIndex += offset;
-        offset += 2;
+//-------------------------------------------------------
+// Name: findPosition
+// Quadratic probing shared by both versions of position, works for any key the hasher accepts
+//---------------------------------------------------------
+template<class Key, class Hash>
+template<class K>
+size_t HashTable<Key, Hash>::findPosition(const K &key) const {
 
-        // When we need to loop back around to the beginning of the table
-        if (currentIndex >= table.size()) {
-            currentIndex -= table.size();
-        }
+    // Before the first insert there's nothing to probe, the key would go in its home cell
+    size_t home = homeIndex(hasher(key), cellCount);
+    if (table.empty()) {
+        return home;
     }
-    return currentIndex;
+    return probeFrom(key, home);
+}
+
+//-------------------------------------------------------
+// Name: probeFrom
+// The probing itself, starting from a home cell that has already been worked out
+//---------------------------------------------------------
+template<class Key, class Hash>
+template<class K>
+size_t HashTable<Key, Hash>::probeFrom(const K &key, size_t home) const {
+
+    // Stop at an empty cell, or at the cell that already holds the key
+    return quadraticProbe(home, table.size(), [this, &key](size_t currentIndex) {
+        return stateOf(table[currentIndex]) == 0 || table[currentIndex].data == key;
+    });
 }
 
 
@@ -353,21 +829,101 @@ size_t HashTable<Key, Hash>::position(const key_type &key) const {
 template<class Key, class Hash>
 void HashTable<Key, Hash>::rehash(size_type count) {
 
-    std::vector<cell> oldTable = table;
+    std::vector<cell> oldTable = std::move(table);
+    size_t oldDisplacement = size_t(maxDisplacement);
 
-    make_empty();
-    table.resize(nextPrime(count));
+    // Brand new cells are empty in every generation
+    cellCount = int(HashPrimes::nextPrime(count));
+    table = std::vector<cell>(cellCount);
     currentSize = 0;
-    cellCount = nextPrime(count);
+    deletedCount = 0;
+    maxDisplacement = 0;
+
+    if (oldTable.size() >= parallelRehashThreshold && WorkStealingPool::shared().thread_count() > 1) {
+        rehashInParallel(oldTable, oldDisplacement);
+        return;
+    }
 
     while (!oldTable.empty()) {
-        if (oldTable.back().state == 1) {
+        if (stateOf(oldTable.back()) == 1) {
             insert(oldTable.back().data);
         }
         oldTable.pop_back();
     }
 }
 
+//-------------------------------------------------------
+// Name: rehashInParallel
+// Moves every key of oldTable into the freshly allocated table, one task per region of new cells.
+// Home cells keep mixed hash order at any size (see scaleHash), so the keys homed in a region
+// were homed in a matching run of old cells, and sit at most oldDisplacement cells past it. Each
+// task walks just that run, probes only inside its own region like build does, and sets aside
+// the keys whose probe sequence would leave it, which get inserted normally at the end.
+//---------------------------------------------------------
+template<class Key, class Hash>
+void HashTable<Key, Hash>::rehashInParallel(const std::vector<cell> &oldTable, size_t oldDisplacement) {
+
+    WorkStealingPool &pool = WorkStealingPool::shared();
+    size_t cells = size_t(cellCount);
+    size_t oldCells = oldTable.size();
+    size_t regions = std::max<size_t>(1, std::min<size_t>(size_t(pool.thread_count()) * 8, cells / regionCells));
+
+    std::vector<size_t> added(regions, 0);
+    std::vector<size_t> farthest(regions, 0);
+    std::vector<std::vector<size_t>> overflow(regions);
+    pool.parallel_for(regions, 1, [&](size_t begin, size_t end) {
+        for (size_t r = begin; r < end; r++) {
+            size_t first = chunkStart(cells, r, regions);
+            size_t last = chunkStart(cells, r + 1, regions);
+
+            // The old home cells of the mixed hashes that land in [first, last)
+            size_t oldFirst = scaleHash(homeStart(first, cells), oldCells);
+            size_t oldLast = last == cells ? oldCells - 1 : scaleHash(homeStart(last, cells) - 1, oldCells);
+            size_t span = std::min(oldCells, oldLast - oldFirst + 1 + oldDisplacement);
+
+            for (size_t step = 0; step < span; step++) {
+                size_t from = (oldFirst + step) % oldCells;
+                if (stateOf(oldTable[from]) != 1) {
+                    continue;
+                }
+                size_t home = homeIndex(hasher(oldTable[from].data), cells);
+                if (home < first || home >= last) {
+                    continue;
+                }
+
+                // The old table has no duplicates, so the first empty cell is the one
+                bool inRegion = true;
+                size_t index = quadraticProbe(home, cells, [&](size_t probe) {
+                    if (probe < first || probe >= last) {
+                        inRegion = false;
+                        return true;
+                    }
+                    return stateOf(table[probe]) == 0;
+                });
+
+                if (!inRegion) {
+                    overflow[r].push_back(from);
+                    continue;
+                }
+                table[index].data = oldTable[from].data;
+                setState(table[index], 1);
+                added[r] += 1;
+                farthest[r] = std::max(farthest[r], index >= home ? index - home : index + cells - home);
+            }
+        }
+    });
+
+    for (size_t r = 0; r < regions; r++) {
+        currentSize += int(added[r]);
+        maxDisplacement = std::max(maxDisplacement, int(farthest[r]));
+    }
+    for (const std::vector<size_t> &leftovers : overflow) {
+        for (size_t from : leftovers) {
+            insert(oldTable[from].data);
+        }
+    }
+}
+
 //-------------------------------------------------------
 // Name: loadFactor
 // Calculates the load factor on the current hashtable
@@ -382,74 +938,516 @@ float HashTable<Key, Hash>::loadFactor() const {
 
 
 //-------------------------------------------------------
-// Name: isPrime
-// Determines whether a given integer is prime or not
+// Name: print_table
+// Outputs the contents of the hashmap to the terminal
 //---------------------------------------------------------
 template<class Key, class Hash>
-bool HashTable<Key, Hash>::isPrime(int count) {
-
-    // Check to get simple cases out of the way first
-    if (count == 2 || count == 3) {
-        return true;
+void HashTable<Key, Hash>::print_table(std::ostream &os) const {
+    if (is_empty()) {
+        std::cout << "<empty>\n";
     }
 
-    // Check for divisibility / count being one before we enter the loop, to save time
-    if (count <= 1 || count % 2 == 0 || count % 3 == 0) {
-        return false;
+    // Loop through the array, and print the contents of each cell, if it's active
+    for (unsigned int i = 0; i < table.size(); i++) {
+        if ((!table.empty()) && stateOf(table.at(i)) == 1) {
+            os << toascii(i) << ": " << (table.at(i).data) << "\n";
+        }
     }
+}
+
+//-------------------------------------------------------
+// Name: keys
+// Collects the data from every active cell into a single vector
+//---------------------------------------------------------
+template<class Key, class Hash>
+std::vector<Key> HashTable<Key, Hash>::keys() const {
+
+    std::vector<Key> allKeys;
+    allKeys.reserve(currentSize);
 
-    // Iterate through the square root of count, checking for factors
-    for (int i = 5; i * i <= count; i += 6) {
-        if (count % i == 0 || count % (i + 2) == 0) {
-            return false;
+    for (unsigned int i = 0; i < table.size(); i++) {
+        if (stateOf(table.at(i)) == 1) {
+            allKeys.push_back(table.at(i).data);
         }
     }
+    return allKeys;
+}
 
-    // If we're here, then the number is prime.
-    return true;
+//-------------------------------------------------------
+// Name: const_iterator
+// Makes an iterator at the given cell, moved forward to the first occupied cell at or after it
+//---------------------------------------------------------
+template<class Key, class Hash>
+HashTable<Key, Hash>::const_iterator::const_iterator(const HashTable *table, size_t start) : owner(table), index(start) {
+    skipInactiveCells();
 }
 
+//-------------------------------------------------------
+// Name: skipInactiveCells
+// Moves forward past empty and deleted cells, stopping at the end of the table
+//---------------------------------------------------------
+template<class Key, class Hash>
+void HashTable<Key, Hash>::const_iterator::skipInactiveCells() {
+    const std::vector<cell> &cells = owner->table;
+    while (index < cells.size() && owner->stateOf(cells[index]) != 1) {
+        index += 1;
+    }
+}
 
 //-------------------------------------------------------
-// Name: nextPrime
-// Finds the next prime number above a given integer
+// Name: begin
+// Returns an iterator to the first key in the table
 //---------------------------------------------------------
 template<class Key, class Hash>
-int HashTable<Key, Hash>::nextPrime(int count) {
+typename HashTable<Key, Hash>::const_iterator HashTable<Key, Hash>::begin() const {
+    return const_iterator(this, 0);
+}
 
-    // Handle base case / negative inputs
-    if (count <= 1) {
-        return 2;
+//-------------------------------------------------------
+// Name: end
+// Returns the iterator one past the last key in the table. Before the first insert there are no
+// cells at all, so begin and end are both at 0.
+//---------------------------------------------------------
+template<class Key, class Hash>
+typename HashTable<Key, Hash>::const_iterator HashTable<Key, Hash>::end() const {
+    return const_iterator(this, table.size());
+}
+
+//-------------------------------------------------------
+// Name: for_each
+// Calls fn on every key in the table, without copying or formatting anything
+//---------------------------------------------------------
+template<class Key, class Hash>
+template<class Fn>
+void HashTable<Key, Hash>::for_each(Fn fn) const {
+    for (const cell &c : table) {
+        if (stateOf(c) == 1) {
+            fn(c.data);
+        }
     }
+}
 
-    int returnPrime = count;
+//-------------------------------------------------------
+// Name: parallel_for_each
+// Calls fn on every key in the table, with the cells split into chunks that the pool's threads
+// work through, stealing from each other. fn gets called from several threads at once, in no
+// particular order.
+//---------------------------------------------------------
+template<class Key, class Hash>
+template<class Fn>
+void HashTable<Key, Hash>::parallel_for_each(Fn fn, WorkStealingPool &pool) const {
+    forEachChunk(pool, table.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            if (stateOf(table[i]) == 1) {
+                fn(table[i].data);
+            }
+        }
+    });
+}
 
-    while (true) {
-        if (isPrime(returnPrime)) {
-            return returnPrime;
+//-------------------------------------------------------
+// Name: parallel_count_if
+// Counts the keys pred returns true for, split up like parallel_for_each. Each chunk is counted
+// locally and only added to the total once it's done, so the threads rarely touch shared memory.
+//---------------------------------------------------------
+template<class Key, class Hash>
+template<class Pred>
+size_t HashTable<Key, Hash>::parallel_count_if(Pred pred, WorkStealingPool &pool) const {
+
+    std::atomic<size_t> total(0);
+    forEachChunk(pool, table.size(), [&](size_t begin, size_t end) {
+        size_t matches = 0;
+        for (size_t i = begin; i < end; i++) {
+            if (stateOf(table[i]) == 1 && pred(table[i].data)) {
+                matches += 1;
+            }
         }
-        returnPrime += 1;
+        total.fetch_add(matches, std::memory_order_relaxed);
+    });
+    return total.load();
+}
+
+//-------------------------------------------------------
+// Name: scan
+// Walks the table a few cells at a time, Redis SCAN style. Start with cursor 0, then keep passing
+// back the returned cursor until it comes back as 0. Each call covers count home cells and calls
+// fn on every key homed in them, which means looking up to maxDisplacement cells further on.
+// Redis resumes across a resize by walking power-of-two tables in reverse-binary order. We get the
+// same effect for any cell count because home cells are picked by scaling the mixed hash (see
+// scaleHash), which keeps them in mixed hash order: the cursor is simply the smallest mixed hash
+// not reported yet, and in any layout those keys are homed at its cell or later. Every key that
+// was in the table for the whole scan is reported exactly once, however much it grew or shrank.
+//---------------------------------------------------------
+template<class Key, class Hash>
+template<class Fn>
+uint64_t HashTable<Key, Hash>::scan(uint64_t cursor, size_t count, Fn fn) const {
+
+    if (table.empty()) {
+        return 0;
     }
 
-    return returnPrime;
+    // This call reports the keys whose mixed hash is in [cursor, next), homed in [first, stop)
+    size_t cells = table.size();
+    size_t first = scaleHash(cursor, cells);
+    size_t stop = std::min(cells, first + std::max<size_t>(count, 1));
+    uint64_t next = stop == cells ? 0 : homeStart(stop, cells);
+
+    size_t visit = std::min(cells, stop - first + size_t(maxDisplacement));
+    size_t index = first;
+    for (size_t i = 0; i < visit; i++) {
+        if (stateOf(table[index]) == 1) {
+            uint64_t mixed = mixHash(hasher(table[index].data));
+            if (mixed >= cursor && (next == 0 || mixed < next)) {
+                fn(table[index].data);
+            }
+        }
+        index = index + 1 == cells ? 0 : index + 1;
+    }
+    return next;
 }
 
 //-------------------------------------------------------
-// Name: print_table
-// Outputs the contents of the hashmap to the terminal
+// Name: freeze
+// Builds an immutable copy of the hashtable with the empty and deleted cells squeezed out
 //---------------------------------------------------------
 template<class Key, class Hash>
-void HashTable<Key, Hash>::print_table(std::ostream &os) const {
+FrozenHashTable<Key, Hash> HashTable<Key, Hash>::freeze() const {
+    return FrozenHashTable<Key, Hash>(keys(), hasher);
+}
+
+//-------------------------------------------------------
+// Name: insert_many
+// Inserts count keys from an array and returns how many were new. The table is grown up front
+// so no rehash happens mid-batch. Home cells are computed a whole batch at a time (by the AVX2
+// kernel when it applies), and while one key is probed the cell of a key further on is prefetched.
+//---------------------------------------------------------
+template<class Key, class Hash>
+size_t HashTable<Key, Hash>::insert_many(const key_type *keys, size_t count) {
+
+    // Make room for every key as if none were duplicates
+    growFor(size_t(currentSize) + count);
+    allocateTable();
+    if (float(size_t(currentSize + deletedCount) + count) / float(cellCount) > maxLoad) {
+        rehash(cellCount);
+    }
+
+    size_t inserted = 0;
+    size_t homes[batchSize];
+    for (size_t start = 0; start < count; start += batchSize) {
+        size_t block = std::min(batchSize, count - start);
+        homeCells(hasher, keys + start, block, size_t(cellCount), homes);
+        for (size_t i = 0; i < std::min(block, prefetchDistance); i++) {
+            prefetchCell(&table[homes[i]]);
+        }
+
+        for (size_t i = 0; i < block; i++) {
+            if (i + prefetchDistance < block) {
+                prefetchCell(&table[homes[i + prefetchDistance]]);
+            }
+            size_t currentIndex = probeFrom(keys[start + i], homes[i]);
+            if (stateOf(table[currentIndex]) != 1) {
+                table[currentIndex].data = keys[start + i];
+                setState(table[currentIndex], 1);
+                noteDisplacement(homes[i], currentIndex);
+                currentSize += 1;
+                inserted += 1;
+            }
+        }
+    }
+    return inserted;
+}
+
+//-------------------------------------------------------
+// Name: contains_many
+// Looks up count keys from an array, writing one result per key, batched the same way as insert_many
+//---------------------------------------------------------
+template<class Key, class Hash>
+void HashTable<Key, Hash>::contains_many(const key_type *keys, size_t count, bool *results) const {
+
     if (is_empty()) {
-        std::cout << "<empty>\n";
+        std::fill(results, results + count, false);
+        return;
     }
 
-    // Loop through the array, and print the contents of each cell, if it's active
-    for (unsigned int i = 0; i < table.size(); i++) {
-        if ((!table.empty()) && table.at(i).state == 1) {
-            os << toascii(i) << ": " << (table.at(i).data) << "\n";
+    size_t homes[batchSize];
+    for (size_t start = 0; start < count; start += batchSize) {
+        size_t block = std::min(batchSize, count - start);
+        homeCells(hasher, keys + start, block, size_t(cellCount), homes);
+        for (size_t i = 0; i < std::min(block, prefetchDistance); i++) {
+            prefetchCell(&table[homes[i]]);
+        }
+
+        for (size_t i = 0; i < block; i++) {
+            if (i + prefetchDistance < block) {
+                prefetchCell(&table[homes[i + prefetchDistance]]);
+            }
+            results[start + i] = stateOf(table[probeFrom(keys[start + i], homes[i])]) == 1;
+        }
+    }
+}
+
+//-------------------------------------------------------
+// Name: build
+// Replaces the hashtable's contents with the keys in [first, last), using several threads. The
+// table is sized for the whole range, keys are partitioned by which region of cells their home
+// falls in, and each thread probes only inside its own region. A key whose probe sequence would
+// leave the region is set aside and inserted normally afterwards, so no cell is ever shared.
+//---------------------------------------------------------
+template<class Key, class Hash>
+template<class RandomIt>
+void HashTable<Key, Hash>::build(RandomIt first, RandomIt last, unsigned threads) {
+
+    size_t count = size_t(last - first);
+    threads = std::max(1u, threads);
+
+    // Start over with enough cells for every key
+    cellCount = int(HashPrimes::nextPrime(std::max<size_t>(cellCount, size_t(float(count) / maxLoad) + 1)));
+    table = std::vector<cell>(cellCount);
+    currentSize = 0;
+    deletedCount = 0;
+    maxDisplacement = 0;
+
+    // Region t is every cell index c with c * threads / cellCount == t
+    size_t cells = size_t(cellCount);
+    std::vector<size_t> homes(count);
+    std::vector<size_t> owners(count);
+    runOnThreads(threads, [&](unsigned t) {
+        for (size_t i = chunkStart(count, t, threads); i < chunkStart(count, t + 1, threads); i++) {
+            homes[i] = homeIndex(hasher(first[i]), cells);
+            owners[i] = homes[i] * threads / cells;
+        }
+    });
+
+    std::vector<size_t> order;
+    std::vector<size_t> starts;
+    partitionIndices(owners, threads, threads, order, starts);
+
+    std::vector<size_t> added(threads, 0);
+    std::vector<size_t> farthest(threads, 0);
+    std::vector<std::vector<size_t>> overflow(threads);
+    runOnThreads(threads, [&](unsigned t) {
+        for (size_t k = starts[t]; k < starts[t + 1]; k++) {
+            size_t i = order[k];
+
+            // Same probing as probeFrom, but bail out as soon as we'd step outside the region
+            bool inRegion = true;
+            size_t currentIndex = quadraticProbe(homes[i], cells, [&](size_t index) {
+                if (index * threads / cells != t) {
+                    inRegion = false;
+                    return true;
+                }
+                return stateOf(table[index]) == 0 || table[index].data == first[i];
+            });
+
+            if (!inRegion) {
+                overflow[t].push_back(i);
+            } else if (stateOf(table[currentIndex]) == 0) {
+                table[currentIndex].data = first[i];
+                setState(table[currentIndex], 1);
+                added[t] += 1;
+                size_t distance = currentIndex >= homes[i] ? currentIndex - homes[i] : currentIndex + cells - homes[i];
+                farthest[t] = std::max(farthest[t], distance);
+            }
+        }
+    });
+
+    for (unsigned t = 0; t < threads; t++) {
+        currentSize += int(added[t]);
+        maxDisplacement = std::max(maxDisplacement, int(farthest[t]));
+    }
+    for (const std::vector<size_t> &leftovers : overflow) {
+        for (size_t i : leftovers) {
+            insert(first[i]);
+        }
+    }
+}
+
+//-------------------------------------------------------
+// Name: containsKey
+// Read-only lookup used by the set operations on the other table, which may not even have cells yet
+//---------------------------------------------------------
+template<class Key, class Hash>
+template<class K>
+bool HashTable<Key, Hash>::containsKey(const K &key) const {
+    return currentSize > 0 && stateOf(table[findPosition(key)]) == 1;
+}
+
+//-------------------------------------------------------
+// Name: findShared
+// Returns the cell of every key of other that we also hold, looking up other's keys in our cells.
+// The lookups don't change anything, so other's cells are split into chunks on the pool.
+//---------------------------------------------------------
+template<class Key, class Hash>
+std::vector<size_t> HashTable<Key, Hash>::findShared(const HashTable &other, WorkStealingPool &pool) const {
+
+    std::vector<size_t> shared;
+    std::mutex sharedMutex;
+    forEachChunk(pool, other.table.size(), [&](size_t begin, size_t end) {
+        std::vector<size_t> found;
+        for (size_t i = begin; i < end; i++) {
+            if (other.stateOf(other.table[i]) == 1) {
+                size_t index = findPosition(other.table[i].data);
+                if (stateOf(table[index]) == 1) {
+                    found.push_back(index);
+                }
+            }
+        }
+        std::lock_guard<std::mutex> lock(sharedMutex);
+        shared.insert(shared.end(), found.begin(), found.end());
+    });
+    return shared;
+}
+
+//-------------------------------------------------------
+// Name: removeCells
+// Marks every occupied cell drop(index) returns true for as deleted, with the cells split into
+// chunks on the pool, then shrinks the table once if that left it sparse
+//---------------------------------------------------------
+template<class Key, class Hash>
+template<class Drop>
+void HashTable<Key, Hash>::removeCells(Drop drop, WorkStealingPool &pool) {
+
+    std::atomic<size_t> removed(0);
+    forEachChunk(pool, table.size(), [&](size_t begin, size_t end) {
+        size_t count = 0;
+        for (size_t i = begin; i < end; i++) {
+            if (stateOf(table[i]) == 1 && drop(i)) {
+                setState(table[i], 2);
+                count += 1;
+            }
+        }
+        removed.fetch_add(count, std::memory_order_relaxed);
+    });
+
+    currentSize -= int(removed.load());
+    deletedCount += int(removed.load());
+    shrinkIfSparse();
+}
+
+//-------------------------------------------------------
+// Name: union_with
+// Adds every key of other to the hashtable (set union). The table is grown once for both tables'
+// keys up front, so none of the inserts rehash.
+//---------------------------------------------------------
+template<class Key, class Hash>
+void HashTable<Key, Hash>::union_with(const HashTable &other) {
+
+    if (this == &other || other.is_empty()) {
+        return;
+    }
+
+    growFor(size_t(currentSize) + size_t(other.currentSize));
+    for (const cell &c : other.table) {
+        if (other.stateOf(c) == 1) {
+            insert(c.data);
         }
     }
 }
 
+//-------------------------------------------------------
+// Name: intersect_with
+// Keeps only the keys other holds too (set intersection). Whichever table is smaller gets looked
+// up in the other one: when it's us, each of our keys is checked in other; when it's other, its
+// keys find the cells to keep and every other cell is deleted. Either way it runs on the pool.
+//---------------------------------------------------------
+template<class Key, class Hash>
+void HashTable<Key, Hash>::intersect_with(const HashTable &other, WorkStealingPool &pool) {
+
+    if (this == &other || is_empty()) {
+        return;
+    }
+
+    if (size() <= other.size()) {
+        removeCells([&](size_t index) {
+            return !other.containsKey(table[index].data);
+        }, pool);
+        return;
+    }
+
+    std::vector<char> keep(table.size(), 0);
+    for (size_t index : findShared(other, pool)) {
+        keep[index] = 1;
+    }
+    removeCells([&](size_t index) {
+        return keep[index] == 0;
+    }, pool);
+}
+
+//-------------------------------------------------------
+// Name: difference_with
+// Removes every key other holds (set difference). Like intersect_with, the smaller table is looked
+// up in the larger one, with the lookups on the pool.
+//---------------------------------------------------------
+template<class Key, class Hash>
+void HashTable<Key, Hash>::difference_with(const HashTable &other, WorkStealingPool &pool) {
+
+    if (is_empty() || other.is_empty()) {
+        return;
+    }
+    if (this == &other) {
+        make_empty();
+        shrinkIfSparse();
+        return;
+    }
+
+    if (size() <= other.size()) {
+        removeCells([&](size_t index) {
+            return other.containsKey(table[index].data);
+        }, pool);
+        return;
+    }
+
+    // Only the cells holding shared keys are touched
+    std::vector<size_t> shared = findShared(other, pool);
+    for (size_t index : shared) {
+        setState(table[index], 2);
+    }
+    currentSize -= int(shared.size());
+    deletedCount += int(shared.size());
+    shrinkIfSparse();
+}
+
+//-------------------------------------------------------
+// Name: is_subset_of
+// Returns whether other holds every key in the hashtable. A bigger table can't be a subset,
+// otherwise our keys are looked up in other on the pool, stopping once one is missing.
+//---------------------------------------------------------
+template<class Key, class Hash>
+bool HashTable<Key, Hash>::is_subset_of(const HashTable &other, WorkStealingPool &pool) const {
+
+    if (size() > other.size()) {
+        return false;
+    }
+    if (this == &other || is_empty()) {
+        return true;
+    }
+
+    std::atomic<bool> missing(false);
+    forEachChunk(pool, table.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end && !missing.load(std::memory_order_relaxed); i++) {
+            if (stateOf(table[i]) == 1 && !other.containsKey(table[i].data)) {
+                missing.store(true, std::memory_order_relaxed);
+            }
+        }
+    });
+    return !missing.load();
+}
+
+//-------------------------------------------------------
+// Name: hash_function
+// Returns a copy of the hashtable's hasher
+//---------------------------------------------------------
+template<class Key, class Hash>
+typename HashTable<Key, Hash>::hash HashTable<Key, Hash>::hash_function() const {
+    return hasher;
+}
+
+//-------------------------------------------------------
+// Name: SeededHashTable
+// A hashtable whose hasher gets a random seed, for keys that come from untrusted input. Only
+// string and integral keys are supported (see SeededHash).
+//---------------------------------------------------------
+template<class Key>
+using SeededHashTable = HashTable<Key, SeededHash<Key>>;
+
 #endif  // HASHTABLE_OPEN_ADDRESSING_H
\ No newline at end of file
@@ -11,12 +11,24 @@
 **
 ***********************************************/
 
+#include <atomic>
 #include <iostream>
 #include <sstream>
 #include "hashtable_open_addressing.h"
+#include "hashtable_hash.h"
+#include "hashtable_perfect.h"
+#include "hashtable_constexpr.h"
+#include "hashtable_small.h"
+#include "hashtable_ordered.h"
 
 using std::cout, std::endl;
 
+// Compile-time tables, these are fully built before main runs
+constexpr auto keywords = make_constexpr_table<std::string_view>({"if", "else", "while", "for", "return", "if"});
+constexpr auto primes = make_constexpr_table<int>({2, 3, 5, 7, 11, 13});
+static_assert(keywords.contains("while") && !keywords.contains("switch"));
+static_assert(primes.contains(7) && !primes.contains(9));
+
 int main() {
     // Example test case in lab document
     std::cout << "make an empty hash table with 11 buckets for strings" << std::endl;
@@ -83,6 +95,355 @@ int main() {
     size_t index = table.position("The Blacksmith and the Artist");
     std::cout << " ==> cell " << index << std::endl;
 
+    // Test freezing the table into its read-only form
+    std::cout << "freeze the table" << std::endl;
+    FrozenHashTable<std::string> frozen = table.freeze();
+    std::cout << "frozen size is " << frozen.size() << std::endl;
+    std::cout << "frozen bucket count is " << frozen.bucket_count() << std::endl;
+    std::cout << "frozen contains 'Sailing into Destiny' " << frozen.contains("Sailing into Destiny") << std::endl;
+    std::cout << "frozen contains 'Each must know their Part' " << frozen.contains("Each must know their Part") << std::endl;
+
+    // Test building a minimal perfect hash from the keys, and round tripping it through a stream
+    std::cout << "build a perfect hash from the keys" << std::endl;
+    PerfectHashTable<std::string> perfect(table.keys());
+    std::cout << "perfect size is " << perfect.size() << std::endl;
+    std::cout << "perfect index of 'I will draw the Chart' is " << perfect.index("I will draw the Chart") << std::endl;
+    {
+        std::stringstream ss;
+        perfect.serialize(ss);
+        PerfectHashTable<std::string> loaded = PerfectHashTable<std::string>::deserialize(ss);
+        std::cout << "loaded contains 'I will draw the Chart' " << loaded.contains("I will draw the Chart") << std::endl;
+        std::cout << "loaded contains 'Each must know their Part' " << loaded.contains("Each must know their Part") << std::endl;
+    }
+
+    // Test that repeated keys are only stored once, and that a corrupt stream is rejected
+    {
+        PerfectHashTable<int> repeats(std::vector<int>{1, 2, 3, 3});
+        std::cout << "perfect hash of {1, 2, 3, 3} has size " << repeats.size() << std::endl;
+
+        std::stringstream ss;
+        repeats.serialize(ss);
+        std::string bytes = ss.str();
+        std::string badHeader = bytes;
+        badHeader[8] = 0;
+        std::string noPilots = bytes;
+        noPilots[16] = 0;
+        for (const std::string &corrupt : {badHeader, noPilots, bytes.substr(0, bytes.size() - 1)}) {
+            std::stringstream in(corrupt);
+            try {
+                PerfectHashTable<int>::deserialize(in);
+                std::cout << "corrupt stream was accepted" << std::endl;
+            } catch (const std::runtime_error &error) {
+                std::cout << "corrupt stream rejected: " << error.what() << std::endl;
+            }
+        }
+    }
+
+    // Test transparent lookups, none of these build a std::string
+    {
+        std::cout << "look up string_views in a transparent table" << std::endl;
+        HashTable<std::string, StringHash> transparent;
+        transparent.insert("Closer to the Heart");
+        transparent.insert("Forge their Creativity");
+        std::string_view request = "GET Closer to the Heart";
+        std::cout << "contains view " << transparent.contains(request.substr(4)) << std::endl;
+        std::cout << "contains literal " << transparent.contains("Forge their Creativity") << std::endl;
+        std::cout << "position of view is " << transparent.position(request.substr(4)) << std::endl;
+        std::cout << "remove view " << transparent.remove(request.substr(4)) << std::endl;
+        std::cout << "size is " << transparent.size() << std::endl;
+    }
+
+    // Test a table with a randomly seeded hasher, copies have to keep the same seed
+    {
+        std::cout << "insert into a seeded table" << std::endl;
+        SeededHashTable<std::string> seeded;
+        seeded.insert("You can be the Captain");
+        seeded.insert("I will draw the Chart");
+        SeededHashTable<std::string> seededCopy(seeded);
+        SeededHashTable<std::string> other;
+        std::cout << "copy contains 'I will draw the Chart' " << seededCopy.contains("I will draw the Chart") << std::endl;
+        std::cout << "copy kept the seed " << (seededCopy.hash_function().seed() == seeded.hash_function().seed()) << std::endl;
+        std::cout << "another table got its own seed " << (other.hash_function().seed() != seeded.hash_function().seed()) << std::endl;
+    }
+
+    // Test building a table from a whole range at once on several threads
+    {
+        std::cout << "build a table from a range on 4 threads" << std::endl;
+        std::vector<int> values;
+        for (int i = 0; i < 1000; i++) {
+            values.push_back(i % 700);
+        }
+        HashTable<int> built;
+        built.build(values.begin(), values.end(), 4);
+        std::cout << "size is " << built.size() << std::endl;
+        std::cout << "contains 699 " << built.contains(699) << " contains 700 " << built.contains(700) << std::endl;
+    }
+
+    // Test presizing, a table told how many keys are coming shouldn't rehash while they arrive
+    {
+        std::cout << "presize a table for 100 keys" << std::endl;
+        HashTable<int> presized(expected_size, 100);
+        size_t cells = presized.table_size();
+        std::vector<int> values;
+        for (int i = 0; i < 100; i++) {
+            values.push_back(i);
+        }
+        presized.insert(values.begin(), values.end());
+        std::cout << "size is " << presized.size() << ", table size unchanged " << (presized.table_size() == cells) << std::endl;
+        presized.reserve(1000);
+        std::cout << "reserve(1000) gives at least 2000 cells " << (presized.table_size() >= 2000) << std::endl;
+    }
+
+    // Test shrinking, removing most of the keys should give most of the cells back
+    {
+        std::cout << "insert 1000 keys and remove 900 of them" << std::endl;
+        HashTable<int> shrinking;
+        for (int i = 0; i < 1000; i++) {
+            shrinking.insert(i);
+        }
+        size_t peak = shrinking.table_size();
+        for (int i = 0; i < 900; i++) {
+            shrinking.remove(i);
+        }
+        std::cout << "size is " << shrinking.size() << ", table size shrank " << (shrinking.table_size() < peak) << std::endl;
+        std::cout << "contains 950 " << shrinking.contains(950) << std::endl;
+        shrinking.shrink_to_fit();
+        std::cout << "after shrink_to_fit the table size is " << shrinking.table_size() << std::endl;
+
+        // shrink_to_fit never grows a table, however small it was made
+        HashTable<int> small(3);
+        small.insert(1);
+        small.shrink_to_fit();
+        HashTable<int> unused;
+        unused.shrink_to_fit();
+        std::cout << "shrink_to_fit takes a table of 3 cells holding 1 key to " << small.table_size() << ", contains 1 " << small.contains(1)
+                  << ", and an unused table to " << unused.table_size() << std::endl;
+    }
+
+    // Test shrinking after a bulk load, only reserve should stop the table from shrinking
+    {
+        std::cout << "range insert 1000 keys and remove 900 of them" << std::endl;
+        std::vector<int> values;
+        for (int i = 0; i < 1000; i++) {
+            values.push_back(i);
+        }
+        HashTable<int> bulk;
+        bulk.insert(values.begin(), values.end());
+        HashTable<int> batched;
+        batched.insert_many(values.data(), values.size());
+        HashTable<int> reserved;
+        reserved.reserve(1000);
+        reserved.insert(values.begin(), values.end());
+        size_t peak = bulk.table_size();
+        for (int i = 0; i < 900; i++) {
+            bulk.remove(i);
+            batched.remove(i);
+            reserved.remove(i);
+        }
+        std::cout << "bulk loaded table size shrank " << (bulk.table_size() < peak) << std::endl;
+        std::cout << "insert_many table size shrank " << (batched.table_size() < peak) << std::endl;
+        std::cout << "reserved table size kept " << (reserved.table_size() >= peak) << std::endl;
+    }
+
+    // Test clearing a big table and reusing it, make_empty shouldn't leave any old keys behind
+    {
+        std::cout << "fill a table, empty it and reuse it" << std::endl;
+        HashTable<int> scratch;
+        for (int i = 0; i < 500; i++) {
+            scratch.insert(i);
+        }
+        scratch.make_empty();
+        scratch.insert(7);
+        std::cout << "size is " << scratch.size() << ", contains 7 " << scratch.contains(7) << ", contains 8 " << scratch.contains(8) << std::endl;
+        std::cout << "keys left " << scratch.keys().size() << std::endl;
+    }
+
+    // Test lazy clearing, stale keys should stay invisible to lookups, copies and iteration
+    {
+        std::cout << "fill a lazily cleared table, empty it and copy it" << std::endl;
+        HashTable<int> lazy;
+        lazy.lazy_clear(true);
+        for (int i = 0; i < 500; i++) {
+            lazy.insert(i);
+        }
+        lazy.make_empty();
+        lazy.insert(7);
+        const HashTable<int> copy = lazy;
+        size_t iterated = 0;
+        for (int key : copy) {
+            iterated += size_t(key == 7);
+        }
+        std::cout << "lazy " << lazy.lazy_clear() << ", contains 8 " << lazy.contains(8) << ", copy keys " << copy.keys().size() << ", iterated " << iterated << std::endl;
+        lazy.lazy_clear(false);
+        std::cout << "after turning it off, size is " << lazy.size() << ", contains 7 " << lazy.contains(7) << ", contains 8 " << lazy.contains(8) << std::endl;
+    }
+
+    // Test the small table, it keeps a few keys inline and only spills into a real table after that
+    {
+        std::cout << "insert into a small table with 4 inline slots" << std::endl;
+        SmallHashTable<HashTable<int>, 4> small;
+        for (int i = 0; i < 4; i++) {
+            small.insert(i);
+        }
+        std::cout << "size is " << small.size() << ", inline " << small.is_inline() << ", contains 3 " << small.contains(3) << std::endl;
+        small.insert(4);
+        std::cout << "size is " << small.size() << ", inline " << small.is_inline() << ", contains 3 " << small.contains(3) << std::endl;
+    }
+
+    // Test the ordered table, it should hand keys back in the order they went in however it's resized
+    {
+        std::cout << "insert into an ordered table" << std::endl;
+        OrderedHashTable<std::string> ordered;
+        ordered.insert("cherry");
+        ordered.insert("apple");
+        ordered.insert("banana");
+        ordered.insert("apple");
+        ordered.remove("apple");
+        ordered.insert("date");
+        for (const std::string &key : ordered) {
+            std::cout << key << " ";
+        }
+        std::cout << std::endl;
+        std::cout << "size is " << ordered.size() << ", contains apple " << ordered.contains("apple")
+                  << ", index slots are " << ordered.index_width() << " byte" << std::endl;
+
+        OrderedHashTable<int> numbers;
+        for (int i = 0; i < 1000; i++) {
+            numbers.insert(999 - i);
+        }
+        for (int i = 0; i < 1000; i += 2) {
+            numbers.remove(i);
+        }
+        std::vector<int> kept = numbers.keys();
+        std::cout << "size is " << numbers.size() << ", first " << kept.front() << ", last " << kept.back()
+                  << ", index slots are " << numbers.index_width() << " bytes" << std::endl;
+    }
+
+    // Test iterating, both with a range-based for loop and with for_each
+    {
+        std::cout << "iterate over a table" << std::endl;
+        HashTable<int> iterated;
+        for (int i = 1; i <= 100; i++) {
+            iterated.insert(i);
+        }
+        int sum = 0;
+        for (int key : iterated) {
+            sum += key;
+        }
+        size_t evens = 0;
+        iterated.for_each([&evens](int key) {
+            evens += key % 2 == 0;
+        });
+        std::cout << "sum is " << sum << ", evens " << evens << ", distance " << std::distance(iterated.begin(), iterated.end()) << std::endl;
+        HashTable<int> empty;
+        std::cout << "empty table begin == end " << (empty.begin() == empty.end()) << std::endl;
+    }
+
+    // Test growing a big table, which rehashes on the thread pool when there's more than one thread
+    {
+        std::cout << "grow a table to 200000 keys" << std::endl;
+        HashTable<int> grown;
+        for (int i = 0; i < 200000; i++) {
+            grown.insert(i * 3);
+        }
+        bool all = true;
+        for (int i = 0; i < 200000; i++) {
+            all = all && grown.contains(i * 3);
+        }
+        std::cout << "size is " << grown.size() << ", contains every key " << all << ", contains 1 " << grown.contains(1) << std::endl;
+    }
+
+    // Test the parallel scans, every key should be seen once whichever thread gets its chunk
+    {
+        std::cout << "scan a table on 4 threads" << std::endl;
+        HashTable<int> scanned;
+        for (int i = 1; i <= 100000; i++) {
+            scanned.insert(i);
+        }
+        WorkStealingPool scanPool(4);
+        std::atomic<long long> sum(0);
+        scanned.parallel_for_each([&sum](int key) {
+            sum += key;
+        }, scanPool);
+        size_t multiples = scanned.parallel_count_if([](int key) {
+            return key % 7 == 0;
+        }, scanPool);
+        std::cout << "sum is " << sum << ", multiples of 7 " << multiples << std::endl;
+    }
+
+    // Test the set operations, the intersection and differences both with the smaller table first and second
+    {
+        std::cout << "combine the multiples of 2 and of 3 under 10000" << std::endl;
+        HashTable<int> twos;
+        HashTable<int> threes;
+        for (int i = 0; i < 10000; i++) {
+            if (i % 2 == 0) {
+                twos.insert(i);
+            }
+            if (i % 3 == 0) {
+                threes.insert(i);
+            }
+        }
+        HashTable<int> both = twos;
+        both.union_with(threes);
+        WorkStealingPool setPool(4);
+        HashTable<int> shared = twos;
+        shared.intersect_with(threes, setPool);
+        HashTable<int> sharedToo = threes;
+        sharedToo.intersect_with(twos, setPool);
+        HashTable<int> onlyTwos = twos;
+        onlyTwos.difference_with(threes, setPool);
+        HashTable<int> onlyThrees = threes;
+        onlyThrees.difference_with(twos, setPool);
+        std::cout << "union " << both.size() << ", intersections " << shared.size() << " and " << sharedToo.size()
+                  << ", differences " << onlyTwos.size() << " and " << onlyThrees.size() << std::endl;
+        std::cout << "intersection contains 6 " << shared.contains(6) << " contains 4 " << shared.contains(4)
+                  << ", difference contains 6 " << onlyTwos.contains(6) << " contains 4 " << onlyTwos.contains(4) << std::endl;
+        std::cout << "intersection is a subset of both " << shared.is_subset_of(twos, setPool) << shared.is_subset_of(threes, setPool)
+                  << ", twos of the union " << twos.is_subset_of(both) << ", twos of threes " << twos.is_subset_of(threes) << std::endl;
+    }
+
+    // Test scanning with a cursor, keys added partway through can make the table grow
+    {
+        std::cout << "scan a table 3 slots at a time while it grows" << std::endl;
+        HashTable<int> scanned;
+        for (int i = 0; i < 50; i++) {
+            scanned.insert(i);
+        }
+        std::vector<bool> seen(50, false);
+        uint64_t cursor = 0;
+        int calls = 0;
+        do {
+            cursor = scanned.scan(cursor, 3, [&seen](int key) {
+                if (key < 50) {
+                    seen[key] = true;
+                }
+            });
+            scanned.insert(1000 + calls);
+            calls += 1;
+        } while (cursor != 0);
+        std::cout << "saw every original key " << (std::count(seen.begin(), seen.end(), true) == 50)
+                  << " in " << calls << " calls, table size " << scanned.size() << std::endl;
+
+        std::cout << "scan it again while it shrinks back down" << std::endl;
+        std::vector<int> reported(50, 0);
+        cursor = 0;
+        calls = 0;
+        do {
+            cursor = scanned.scan(cursor, 3, [&reported](int key) {
+                if (key < 50) {
+                    reported[key] += 1;
+                }
+            });
+            for (int i = 0; i < 5; i++) {
+                scanned.remove(1000 + 5 * calls + i);
+            }
+            calls += 1;
+        } while (cursor != 0);
+        std::cout << "saw every original key exactly once " << (std::count(reported.begin(), reported.end(), 1) == 50)
+                  << ", table size " << scanned.size() << std::endl;
+    }
+
     std::cout << "make the table empty" << std::endl;
     table.make_empty();
 
@@ -96,5 +457,21 @@ int main() {
         std::cout << ss.str() << std::endl;
     }
 
+    // Test the batched insert and lookup
+    {
+        std::cout << "insert_many and contains_many on uint32_t keys" << std::endl;
+        uint32_t values[] = {4, 8, 15, 16, 23, 42, 4, 8, 108, 4294967295u};
+        HashTable<uint32_t> numbers;
+        std::cout << "inserted " << numbers.insert_many(values, 10) << " new keys, size is " << numbers.size() << std::endl;
+        uint32_t queries[] = {15, 16, 17, 4294967295u};
+        bool results[4];
+        numbers.contains_many(queries, 4, results);
+        std::cout << "results " << results[0] << results[1] << results[2] << results[3] << std::endl;
+    }
+
+    std::cout << "compile-time keyword table size is " << keywords.size() << " in " << keywords.table_size() << " cells" << std::endl;
+    std::cout << "keywords contains 'return' " << keywords.contains("return") << std::endl;
+    std::cout << "primes contains 12 " << primes.contains(12) << std::endl;
+
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,456 @@
+/*****************************************
+** File:    hashtable_ordered.h
+** Project: CSCE 221 Lab 6 Spring 2022
+** Author:  Joshua Hillis
+** Date:    04/12/2022
+** Section: 512
+** E-mail:  joshuahillis292002@tamu.edu
+**
+** This is the header file for the ordered hashtable, laid out like Python's compact dict. The
+** keys sit in one dense array in insertion order, and the hash index only holds small integer
+** positions into it, probed quadratically like the open addressing table. Each index slot is
+** 1, 2, 4 or 8 bytes, whatever is just wide enough for the index's size, so a table with plenty
+** of empty slots costs little, and iterating is a straight walk of the packed key array.
+**
+***********************************************/
+
+#ifndef HASHTABLE_ORDERED_H
+#define HASHTABLE_ORDERED_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <vector>
+#include "hashtable_hash.h"
+#include "hashtable_primes.h"
+
+template<class Key, class Hash=std::hash<Key>>
+class OrderedHashTable {
+public:
+    using key_type = Key;
+    using value_type = Key;
+    using hash = Hash;
+    using size_type = size_t;
+
+private:
+    // Every key ever inserted, in insertion order. A removed key stays where it is, flagged in
+    // removed, until the next rebuild packs the array
+    std::vector<Key> entries;
+    std::vector<bool> removed;
+    size_t currentSize;
+    // cellCount slots of width bytes each: 0 is an empty slot, 1 a slot whose key was removed,
+    // and i + 2 points at entries[i]. It stays empty (and unallocated) until the first insert.
+    std::vector<unsigned char> index;
+    size_t cellCount;
+    size_t width;
+    // The index never shrinks below this, the size asked for by reserve
+    size_t minCells;
+    Hash hasher;
+
+    static size_t widthFor(size_t cells);
+
+    size_t slotAt(size_t cell) const;
+
+    void setSlot(size_t cell, size_t value);
+
+    size_t findCell(const key_type &key) const;
+
+    void rebuild(size_t cells);
+
+public:
+    // Forward iterator over the keys in the order they were inserted
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Key;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Key *;
+        using reference = const Key &;
+
+        const_iterator() : owner(nullptr), position(0) {}
+
+        reference operator*() const { return owner->entries[position]; }
+
+        pointer operator->() const { return &owner->entries[position]; }
+
+        const_iterator &operator++() {
+            position += 1;
+            skipRemoved();
+            return *this;
+        }
+
+        const_iterator operator++(int) {
+            const_iterator old = *this;
+            ++*this;
+            return old;
+        }
+
+        bool operator==(const const_iterator &other) const { return position == other.position; }
+
+        bool operator!=(const const_iterator &other) const { return position != other.position; }
+
+    private:
+        friend class OrderedHashTable;
+
+        const OrderedHashTable *owner;
+        size_t position;
+
+        const_iterator(const OrderedHashTable *table, size_t start) : owner(table), position(start) {
+            skipRemoved();
+        }
+
+        void skipRemoved() {
+            while (position < owner->entries.size() && owner->removed[position]) {
+                position += 1;
+            }
+        }
+    };
+
+    using iterator = const_iterator;
+
+    OrderedHashTable();
+
+    OrderedHashTable(expected_size_t, size_type count);
+
+    bool is_empty() const;
+
+    size_t size() const;
+
+    size_t table_size() const;
+
+    size_t index_width() const;
+
+    size_t memory_usage() const;
+
+    void make_empty();
+
+    bool insert(const value_type &value);
+
+    size_t remove(const key_type &key);
+
+    bool contains(const key_type &key) const;
+
+    void reserve(size_type count);
+
+    std::vector<Key> keys() const;
+
+    const_iterator begin() const;
+
+    const_iterator end() const;
+
+    hash hash_function() const;
+};
+
+//-------------------------------------------------------
+// Name: Default Constructor
+// Initializes an empty ordered hashtable. Like the other tables nothing is allocated until the
+// first insert, the index is still 11 one byte slots.
+//---------------------------------------------------------
+template<class Key, class Hash>
+OrderedHashTable<Key, Hash>::OrderedHashTable() {
+    currentSize = 0;
+    cellCount = 11;
+    width = widthFor(cellCount);
+    minCells = cellCount;
+}
+
+//-------------------------------------------------------
+// Name: Presizing Constructor
+// Initializes a table that is about to receive count keys, sized so none of them cause a rebuild
+//---------------------------------------------------------
+template<class Key, class Hash>
+OrderedHashTable<Key, Hash>::OrderedHashTable(expected_size_t, size_type count) : OrderedHashTable() {
+    reserve(count);
+}
+
+//-------------------------------------------------------
+// Name: is_empty
+// Returns true or false depending on whether the table is empty or not
+//---------------------------------------------------------
+template<class Key, class Hash>
+bool OrderedHashTable<Key, Hash>::is_empty() const {
+    return currentSize == 0;
+}
+
+//-------------------------------------------------------
+// Name: size
+// Returns the number of keys in the table, not counting removed ones still waiting to be packed away
+//---------------------------------------------------------
+template<class Key, class Hash>
+size_t OrderedHashTable<Key, Hash>::size() const {
+    return currentSize;
+}
+
+//-------------------------------------------------------
+// Name: table_size
+// Returns the number of slots in the hash index
+//---------------------------------------------------------
+template<class Key, class Hash>
+size_t OrderedHashTable<Key, Hash>::table_size() const {
+    return cellCount;
+}
+
+//-------------------------------------------------------
+// Name: index_width
+// Returns how many bytes each slot of the hash index takes: 1, 2, 4 or 8
+//---------------------------------------------------------
+template<class Key, class Hash>
+size_t OrderedHashTable<Key, Hash>::index_width() const {
+    return width;
+}
+
+//-------------------------------------------------------
+// Name: memory_usage
+// Returns the bytes the index and the key array have allocated, not counting anything the keys
+// allocate themselves (a long string's characters, say)
+//---------------------------------------------------------
+template<class Key, class Hash>
+size_t OrderedHashTable<Key, Hash>::memory_usage() const {
+    return index.capacity() + entries.capacity() * sizeof(Key) + removed.capacity() / 8;
+}
+
+//-------------------------------------------------------
+// Name: make_empty
+// Removes every key, keeping the index at its current size
+//---------------------------------------------------------
+template<class Key, class Hash>
+void OrderedHashTable<Key, Hash>::make_empty() {
+    entries.clear();
+    removed.clear();
+    currentSize = 0;
+    std::fill(index.begin(), index.end(), 0);
+}
+
+//-------------------------------------------------------
+// Name: insert
+// Appends the key to the key array if it isn't there yet. Every key ever appended (removed or
+// not) holds an index slot, and those have to stay at most half of the index for quadratic
+// probing to always find an empty slot, so the table is rebuilt before that would happen.
+//---------------------------------------------------------
+template<class Key, class Hash>
+bool OrderedHashTable<Key, Hash>::insert(const value_type &value) {
+
+    if (index.empty()) {
+        index.assign(cellCount * width, 0);
+    }
+
+    size_t cell = findCell(value);
+    if (slotAt(cell) != 0) {
+        return false;
+    }
+
+    if ((entries.size() + 1) * 2 > cellCount) {
+        // Leave room for as many keys again, which is all a rebuild that only packs away removed keys needs too
+        rebuild(HashPrimes::nextPrime(std::max(minCells, 4 * (currentSize + 1))));
+        cell = findCell(value);
+    }
+
+    entries.push_back(value);
+    removed.push_back(false);
+    setSlot(cell, entries.size() + 1);
+    currentSize += 1;
+    return true;
+}
+
+//-------------------------------------------------------
+// Name: remove
+// Removes the key if it's there. Its slot is marked removed so probe sequences going through it
+// still work, and once three quarters of the key array is removed keys the table is rebuilt
+// smaller, packing them away.
+//---------------------------------------------------------
+template<class Key, class Hash>
+size_t OrderedHashTable<Key, Hash>::remove(const key_type &key) {
+
+    if (currentSize == 0) {
+        return 0;
+    }
+
+    size_t cell = findCell(key);
+    size_t slot = slotAt(cell);
+    if (slot == 0) {
+        return 0;
+    }
+
+    removed[slot - 2] = true;
+    setSlot(cell, 1);
+    currentSize -= 1;
+
+    if (currentSize < entries.size() / 4) {
+        rebuild(HashPrimes::nextPrime(std::max(minCells, 4 * currentSize)));
+    }
+    return 1;
+}
+
+//-------------------------------------------------------
+// Name: contains
+// Returns true or false depending on whether the key is in the table
+//---------------------------------------------------------
+template<class Key, class Hash>
+bool OrderedHashTable<Key, Hash>::contains(const key_type &key) const {
+    return currentSize != 0 && slotAt(findCell(key)) != 0;
+}
+
+//-------------------------------------------------------
+// Name: reserve
+// Makes room for count keys, so inserting that many never rebuilds the table. Removing keys won't
+// shrink the index below this size either.
+//---------------------------------------------------------
+template<class Key, class Hash>
+void OrderedHashTable<Key, Hash>::reserve(size_type count) {
+
+    entries.reserve(count);
+    removed.reserve(count);
+    minCells = std::max(minCells, HashPrimes::nextPrime(2 * count + 1));
+    if (minCells > cellCount) {
+        rebuild(minCells);
+    }
+}
+
+//-------------------------------------------------------
+// Name: keys
+// Collects every key into a single vector, in insertion order
+//---------------------------------------------------------
+template<class Key, class Hash>
+std::vector<Key> OrderedHashTable<Key, Hash>::keys() const {
+    return std::vector<Key>(begin(), end());
+}
+
+//-------------------------------------------------------
+// Name: begin
+// Returns an iterator to the first key inserted that's still in the table
+//---------------------------------------------------------
+template<class Key, class Hash>
+typename OrderedHashTable<Key, Hash>::const_iterator OrderedHashTable<Key, Hash>::begin() const {
+    return const_iterator(this, 0);
+}
+
+//-------------------------------------------------------
+// Name: end
+// Returns the iterator one past the last key
+//---------------------------------------------------------
+template<class Key, class Hash>
+typename OrderedHashTable<Key, Hash>::const_iterator OrderedHashTable<Key, Hash>::end() const {
+    return const_iterator(this, entries.size());
+}
+
+//-------------------------------------------------------
+// Name: hash_function
+// Returns a copy of the table's hasher
+//---------------------------------------------------------
+template<class Key, class Hash>
+typename OrderedHashTable<Key, Hash>::hash OrderedHashTable<Key, Hash>::hash_function() const {
+    return hasher;
+}
+
+//-------------------------------------------------------
+// Name: widthFor
+// The narrowest slot that can hold every value an index of the given size stores. At most half
+// of the slots point at keys, so the largest value, the last key's position + 2, is under cells.
+//---------------------------------------------------------
+template<class Key, class Hash>
+size_t OrderedHashTable<Key, Hash>::widthFor(size_t cells) {
+    if (cells <= UINT8_MAX) {
+        return 1;
+    } else if (cells <= UINT16_MAX) {
+        return 2;
+    } else if (cells <= UINT32_MAX) {
+        return 4;
+    }
+    return 8;
+}
+
+//-------------------------------------------------------
+// Name: slotAt
+// Reads one slot of the index. The slots are packed bytes, so they're copied out rather than
+// read through a cast pointer, which the compiler still turns into a single load.
+//---------------------------------------------------------
+template<class Key, class Hash>
+size_t OrderedHashTable<Key, Hash>::slotAt(size_t cell) const {
+    const unsigned char *slot = index.data() + cell * width;
+    if (width == 1) {
+        return *slot;
+    } else if (width == 2) {
+        uint16_t value;
+        std::memcpy(&value, slot, sizeof(value));
+        return value;
+    } else if (width == 4) {
+        uint32_t value;
+        std::memcpy(&value, slot, sizeof(value));
+        return value;
+    }
+    uint64_t value;
+    std::memcpy(&value, slot, sizeof(value));
+    return size_t(value);
+}
+
+//-------------------------------------------------------
+// Name: setSlot
+// Writes one slot of the index, the value has to fit in width bytes
+//---------------------------------------------------------
+template<class Key, class Hash>
+void OrderedHashTable<Key, Hash>::setSlot(size_t cell, size_t value) {
+    unsigned char *slot = index.data() + cell * width;
+    if (width == 1) {
+        *slot = static_cast<unsigned char>(value);
+    } else if (width == 2) {
+        uint16_t narrowed = static_cast<uint16_t>(value);
+        std::memcpy(slot, &narrowed, sizeof(narrowed));
+    } else if (width == 4) {
+        uint32_t narrowed = static_cast<uint32_t>(value);
+        std::memcpy(slot, &narrowed, sizeof(narrowed));
+    } else {
+        uint64_t widened = value;
+        std::memcpy(slot, &widened, sizeof(widened));
+    }
+}
+
+//-------------------------------------------------------
+// Name: findCell
+// The same quadratic probing as the open addressing table's position: returns the slot pointing
+// at the key, or the empty slot it would go in. Removed slots are probed past.
+//---------------------------------------------------------
+template<class Key, class Hash>
+size_t OrderedHashTable<Key, Hash>::findCell(const key_type &key) const {
+    return quadraticProbe(homeIndex(hasher(key), cellCount), cellCount, [this, &key](size_t cell) {
+        size_t slot = slotAt(cell);
+        return slot == 0 || (slot >= 2 && entries[slot - 2] == key);
+    });
+}
+
+//-------------------------------------------------------
+// Name: rebuild
+// Packs the removed keys out of the key array, keeping the rest in order, and builds a fresh
+// index with the given number of slots pointing at them
+//---------------------------------------------------------
+template<class Key, class Hash>
+void OrderedHashTable<Key, Hash>::rebuild(size_t cells) {
+
+    if (currentSize != entries.size()) {
+        size_t kept = 0;
+        for (size_t i = 0; i < entries.size(); i++) {
+            if (!removed[i]) {
+                if (kept != i) {
+                    entries[kept] = std::move(entries[i]);
+                }
+                kept += 1;
+            }
+        }
+        entries.erase(entries.begin() + kept, entries.end());
+    }
+    removed.assign(entries.size(), false);
+
+    cellCount = cells;
+    width = widthFor(cellCount);
+    index.assign(cellCount * width, 0);
+    for (size_t i = 0; i < entries.size(); i++) {
+        size_t cell = quadraticProbe(homeIndex(hasher(entries[i]), cellCount), cellCount, [this](size_t candidate) {
+            return slotAt(candidate) == 0;
+        });
+        setSlot(cell, i + 2);
+    }
+}
+
+#endif  // HASHTABLE_ORDERED_H
@@ -0,0 +1,98 @@
+/*****************************************
+** File:    hashtable_parallel.h
+** Project: CSCE 221 Lab 6 Spring 2022
+** Author:  Joshua Hillis
+** Date:    04/12/2022
+** Section: 512
+** E-mail:  joshuahillis292002@tamu.edu
+**
+** This is the header file for the small threading helpers the hashtables use for their bulk
+** operations: running a function on N threads, splitting a range into fixed chunks, and a
+** parallel stable partition of keys by which thread owns them.
+**
+***********************************************/
+
+#ifndef HASHTABLE_PARALLEL_H
+#define HASHTABLE_PARALLEL_H
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+//-------------------------------------------------------
+// Name: defaultThreadCount
+// The number of hardware threads, or 1 if the platform can't tell us
+//---------------------------------------------------------
+inline unsigned defaultThreadCount() {
+    unsigned count = std::thread::hardware_concurrency();
+    return count == 0 ? 1 : count;
+}
+
+//-------------------------------------------------------
+// Name: chunkStart
+// Where the given chunk starts when count items are split into parts nearly equal chunks
+//---------------------------------------------------------
+inline size_t chunkStart(size_t count, size_t part, size_t parts) {
+    // Same as count * part / parts, without overflowing
+    return count / parts * part + count % parts * part / parts;
+}
+
+//-------------------------------------------------------
+// Name: runOnThreads
+// Calls fn(t) for every t in [0, threads), each on its own thread (t = 0 on the calling one),
+// and returns once all of them are done
+//---------------------------------------------------------
+template<class Fn>
+void runOnThreads(unsigned threads, Fn fn) {
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+    for (unsigned t = 1; t < threads; t++) {
+        workers.emplace_back(fn, t);
+    }
+    fn(0u);
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+}
+
+//-------------------------------------------------------
+// Name: partitionIndices
+// Stable counting sort of the indices [0, parts.size()) by parts[i], spread over threads. On
+// return, order[starts[p]] to order[starts[p + 1]] are the indices in partition p, in input order.
+//---------------------------------------------------------
+inline void partitionIndices(const std::vector<size_t> &parts, size_t partCount, unsigned threads,
+                             std::vector<size_t> &order, std::vector<size_t> &starts) {
+
+    size_t count = parts.size();
+    // counts[c * partCount + p] is how many of chunk c's indices go to partition p
+    std::vector<size_t> counts(size_t(threads) * partCount, 0);
+    runOnThreads(threads, [&](unsigned c) {
+        size_t *histogram = &counts[size_t(c) * partCount];
+        for (size_t i = chunkStart(count, c, threads); i < chunkStart(count, c + 1, threads); i++) {
+            histogram[parts[i]] += 1;
+        }
+    });
+
+    // Turn the counts into write offsets, partition by partition and chunk by chunk within each
+    starts = std::vector<size_t>(partCount + 1, 0);
+    size_t offset = 0;
+    for (size_t p = 0; p < partCount; p++) {
+        starts[p] = offset;
+        for (unsigned c = 0; c < threads; c++) {
+            size_t chunkCount = counts[size_t(c) * partCount + p];
+            counts[size_t(c) * partCount + p] = offset;
+            offset += chunkCount;
+        }
+    }
+    starts[partCount] = offset;
+
+    order = std::vector<size_t>(count);
+    runOnThreads(threads, [&](unsigned c) {
+        size_t *cursor = &counts[size_t(c) * partCount];
+        for (size_t i = chunkStart(count, c, threads); i < chunkStart(count, c + 1, threads); i++) {
+            order[cursor[parts[i]]++] = i;
+        }
+    });
+}
+
+#endif  // HASHTABLE_PARALLEL_H
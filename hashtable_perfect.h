@@ -0,0 +1,451 @@
+/*****************************************
+** File:    hashtable_perfect.h
+** Project: CSCE 221 Lab 6 Spring 2022
+** Author:  Joshua Hillis
+** Date:    04/12/2022
+** Section: 512
+** E-mail:  joshuahillis292002@tamu.edu
+**
+** This is the header file for the minimal perfect hashtable. It is built once from a static
+** set of keys (the keys() of either hashtable, or any range) and maps every key to its own
+** slot in [0, n), PTHash style: keys are split into small buckets and each bucket stores a
+** "pilot" value that was searched for at build time so none of its keys collide. A lookup is
+** one hash, one index computation and one compare against the verification array of keys.
+**
+***********************************************/
+
+#ifndef HASHTABLE_PERFECT_H
+#define HASHTABLE_PERFECT_H
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "hashtable_hash.h"
+
+template<class Key, class Hash=std::hash<Key>>
+class PerfectHashTable {
+public:
+    using key_type = Key;
+    using value_type = Key;
+    using hash = Hash;
+    using size_type = size_t;
+
+private:
+    // Average number of keys per bucket, and how many slots we allow per key before remapping
+    static constexpr size_t bucketLoad = 2;
+    static constexpr double slotLoad = 0.99;
+    // Give up on a bucket after this many pilots, since it means two keys hash identically
+    static constexpr uint32_t maxPilot = 1u << 24;
+
+    size_t keyCount;
+    size_t slotCount;
+    std::vector<uint32_t> pilots;
+    // Slots at or past keyCount are remapped into the holes left below keyCount
+    std::vector<size_t> remap;
+    // The verification array, keys[i] is the only key that can live in slot i
+    std::vector<Key> keys;
+    Hash hasher;
+
+    static uint64_t mix(uint64_t value);
+
+    size_t bucketOf(uint64_t hashVal) const;
+
+    size_t slotOf(uint64_t hashVal, uint32_t pilot) const;
+
+    void build(const std::vector<Key> &values);
+
+    static void writeKey(std::ostream &os, const Key &key);
+
+    static Key readKey(std::istream &is);
+
+public:
+    PerfectHashTable();
+
+    explicit PerfectHashTable(const std::vector<Key> &values, const Hash &hashFunction = Hash());
+
+    template<class InputIt>
+    PerfectHashTable(InputIt first, InputIt last, const Hash &hashFunction = Hash());
+
+    bool is_empty() const;
+
+    size_t size() const;
+
+    size_t index(const key_type &key) const;
+
+    bool contains(const key_type &key) const;
+
+    void serialize(std::ostream &os) const;
+
+    static PerfectHashTable deserialize(std::istream &is, const Hash &hashFunction = Hash());
+};
+
+//-------------------------------------------------------
+// Name: Default Constructor
+// Initializes an empty perfect hashtable
+//---------------------------------------------------------
+template<class Key, class Hash>
+PerfectHashTable<Key, Hash>::PerfectHashTable() {
+    keyCount = 0;
+    slotCount = 0;
+}
+
+//-------------------------------------------------------
+// Name: Parameterized Constructor
+// Builds the perfect hash for a list of keys, repeated keys are only stored once
+//---------------------------------------------------------
+template<class Key, class Hash>
+PerfectHashTable<Key, Hash>::PerfectHashTable(const std::vector<Key> &values, const Hash &hashFunction) {
+    hasher = hashFunction;
+    build(values);
+}
+
+//-------------------------------------------------------
+// Name: Range Constructor
+// Builds the perfect hash for the keys in [first, last), repeated keys are only stored once
+//---------------------------------------------------------
+template<class Key, class Hash>
+template<class InputIt>
+PerfectHashTable<Key, Hash>::PerfectHashTable(InputIt first, InputIt last, const Hash &hashFunction) {
+    hasher = hashFunction;
+    build(std::vector<Key>(first, last));
+}
+
+//-------------------------------------------------------
+// Name: mix
+// Finalizer from splitmix64, spreads the bits of std::hash (the identity for integers)
+//---------------------------------------------------------
+template<class Key, class Hash>
+uint64_t PerfectHashTable<Key, Hash>::mix(uint64_t value) {
+    value ^= value >> 30;
+    value *= 0xbf58476d1ce4e5b9ULL;
+    value ^= value >> 27;
+    value *= 0x94d049bb133111ebULL;
+    value ^= value >> 31;
+    return value;
+}
+
+//-------------------------------------------------------
+// Name: bucketOf
+// Returns the bucket, and therefore the pilot, a hash value belongs to
+//---------------------------------------------------------
+template<class Key, class Hash>
+size_t PerfectHashTable<Key, Hash>::bucketOf(uint64_t hashVal) const {
+    return mix(hashVal) % pilots.size();
+}
+
+//-------------------------------------------------------
+// Name: slotOf
+// Returns the slot a hash value lands in for a given pilot, after remapping
+//---------------------------------------------------------
+template<class Key, class Hash>
+size_t PerfectHashTable<Key, Hash>::slotOf(uint64_t hashVal, uint32_t pilot) const {
+    size_t slot = mix(hashVal ^ mix(pilot + 0x9e3779b97f4a7c15ULL)) % slotCount;
+    if (slot >= keyCount) {
+        slot = remap[slot - keyCount];
+    }
+    return slot;
+}
+
+//-------------------------------------------------------
+// Name: build
+// Searches a pilot for every bucket, biggest buckets first, so that all keys get distinct slots
+//---------------------------------------------------------
+template<class Key, class Hash>
+void PerfectHashTable<Key, Hash>::build(const std::vector<Key> &values) {
+
+    // No pilot can ever separate two keys with the same hash, so look for them before searching.
+    // A repeated key is dropped, two different keys with the same hash are an error.
+    std::vector<uint64_t> valueHashes(values.size());
+    std::vector<size_t> byHash(values.size());
+    for (size_t i = 0; i < values.size(); i++) {
+        valueHashes.at(i) = hasher(values.at(i));
+        byHash.at(i) = i;
+    }
+    std::sort(byHash.begin(), byHash.end(), [&valueHashes](size_t lhs, size_t rhs) {
+        return valueHashes[lhs] < valueHashes[rhs];
+    });
+    std::vector<bool> repeated(values.size(), false);
+    bool anyRepeated = false;
+    for (size_t i = 1, first = 0; i < byHash.size(); i++) {
+        if (valueHashes.at(byHash.at(i)) != valueHashes.at(byHash.at(first))) {
+            first = i;
+        } else if (values.at(byHash.at(i)) == values.at(byHash.at(first))) {
+            repeated.at(byHash.at(i)) = true;
+            anyRepeated = true;
+        } else {
+            throw std::invalid_argument("Two different keys have the same hash!");
+        }
+    }
+    if (anyRepeated) {
+        std::vector<Key> unique;
+        unique.reserve(values.size());
+        for (size_t i = 0; i < values.size(); i++) {
+            if (!repeated.at(i)) {
+                unique.push_back(values.at(i));
+            }
+        }
+        build(unique);
+        return;
+    }
+
+    keyCount = values.size();
+    slotCount = std::max(keyCount, size_t(double(keyCount) / slotLoad));
+    pilots = std::vector<uint32_t>(keyCount / bucketLoad + 1, 0);
+    remap.clear();
+    keys.clear();
+
+    if (keyCount == 0) {
+        return;
+    }
+
+    // Group the key hashes by bucket, counting sort style so each bucket is a contiguous run
+    const std::vector<uint64_t> &hashes = valueHashes;
+    std::vector<size_t> start(pilots.size() + 1, 0);
+    for (size_t i = 0; i < keyCount; i++) {
+        start.at(bucketOf(hashes.at(i)) + 1) += 1;
+    }
+    for (size_t b = 0; b < pilots.size(); b++) {
+        start.at(b + 1) += start.at(b);
+    }
+    std::vector<size_t> fill(start.begin(), start.end() - 1);
+    std::vector<size_t> members(keyCount);
+    for (size_t i = 0; i < keyCount; i++) {
+        members.at(fill.at(bucketOf(hashes.at(i)))++) = i;
+    }
+
+    // Hardest buckets first, while there is still plenty of room
+    std::vector<size_t> order(pilots.size());
+    for (size_t b = 0; b < order.size(); b++) {
+        order.at(b) = b;
+    }
+    std::stable_sort(order.begin(), order.end(), [&start](size_t lhs, size_t rhs) {
+        return start.at(lhs + 1) - start.at(lhs) > start.at(rhs + 1) - start.at(rhs);
+    });
+
+    // Place the buckets over the full slot range; the remap into [0, keyCount) comes afterwards
+    std::vector<bool> taken(slotCount, false);
+    std::vector<size_t> owner(slotCount, keyCount);
+    std::vector<size_t> candidate;
+    for (size_t b : order) {
+        if (start.at(b) == start.at(b + 1)) {
+            break;
+        }
+
+        for (uint32_t pilot = 0; ; pilot++) {
+            if (pilot == maxPilot) {
+                throw std::invalid_argument("No pilot separates a bucket's keys!");
+            }
+
+            candidate.clear();
+            bool fits = true;
+            uint64_t pilotHash = mix(pilot + 0x9e3779b97f4a7c15ULL);
+            for (size_t m = start[b]; m < start[b + 1]; m++) {
+                size_t slot = mix(hashes[members[m]] ^ pilotHash) % slotCount;
+                if (taken[slot] || std::find(candidate.begin(), candidate.end(), slot) != candidate.end()) {
+                    fits = false;
+                    break;
+                }
+                candidate.push_back(slot);
+            }
+
+            if (fits) {
+                pilots.at(b) = pilot;
+                for (size_t i = 0; i < candidate.size(); i++) {
+                    taken.at(candidate.at(i)) = true;
+                    owner.at(candidate.at(i)) = members.at(start.at(b) + i);
+                }
+                break;
+            }
+        }
+    }
+
+    // Every slot taken past keyCount gets pointed at one of the holes below keyCount
+    remap = std::vector<size_t>(slotCount - keyCount, 0);
+    size_t hole = 0;
+    for (size_t slot = keyCount; slot < slotCount; slot++) {
+        if (taken.at(slot)) {
+            while (taken.at(hole)) {
+                hole += 1;
+            }
+            remap.at(slot - keyCount) = hole;
+            taken.at(hole) = true;
+            owner.at(hole) = owner.at(slot);
+            hole += 1;
+        }
+    }
+
+    keys.reserve(keyCount);
+    for (size_t slot = 0; slot < keyCount; slot++) {
+        keys.push_back(values.at(owner.at(slot)));
+    }
+}
+
+//-------------------------------------------------------
+// Name: is_empty
+// Returns true or false depending on whether the table holds any keys
+//---------------------------------------------------------
+template<class Key, class Hash>
+bool PerfectHashTable<Key, Hash>::is_empty() const {
+    return keyCount == 0;
+}
+
+//-------------------------------------------------------
+// Name: size
+// Returns the number of keys in the table
+//---------------------------------------------------------
+template<class Key, class Hash>
+size_t PerfectHashTable<Key, Hash>::size() const {
+    return keyCount;
+}
+
+//-------------------------------------------------------
+// Name: index
+// Returns the slot in [0, size()) the key maps to. Keys that were not in the build set still
+// map to some slot, so use contains to check membership.
+//---------------------------------------------------------
+template<class Key, class Hash>
+size_t PerfectHashTable<Key, Hash>::index(const key_type &key) const {
+    if (keyCount == 0) {
+        throw std::out_of_range("Perfect hashtable is empty!");
+    }
+    uint64_t hashVal = hasher(key);
+    return slotOf(hashVal, pilots[bucketOf(hashVal)]);
+}
+
+//-------------------------------------------------------
+// Name: contains
+// Returns true or false depending on whether the key was one of the keys the table was built from
+//---------------------------------------------------------
+template<class Key, class Hash>
+bool PerfectHashTable<Key, Hash>::contains(const key_type &key) const {
+    if (keyCount == 0) {
+        return false;
+    }
+    uint64_t hashVal = hasher(key);
+    return keys[slotOf(hashVal, pilots[bucketOf(hashVal)])] == key;
+}
+
+//-------------------------------------------------------
+// Name: writeKey
+// Writes one key in binary, strings are written as a length followed by their characters
+//---------------------------------------------------------
+template<class Key, class Hash>
+void PerfectHashTable<Key, Hash>::writeKey(std::ostream &os, const Key &key) {
+    if constexpr (std::is_same_v<Key, std::string>) {
+        uint64_t length = key.size();
+        os.write(reinterpret_cast<const char *>(&length), sizeof length);
+        os.write(key.data(), std::streamsize(length));
+    } else {
+        static_assert(std::is_trivially_copyable_v<Key>, "Only strings and trivially copyable keys can be serialized");
+        os.write(reinterpret_cast<const char *>(&key), sizeof key);
+    }
+}
+
+//-------------------------------------------------------
+// Name: readKey
+// Reads back one key written by writeKey
+//---------------------------------------------------------
+template<class Key, class Hash>
+Key PerfectHashTable<Key, Hash>::readKey(std::istream &is) {
+    if constexpr (std::is_same_v<Key, std::string>) {
+        uint64_t length = 0;
+        is.read(reinterpret_cast<char *>(&length), sizeof length);
+
+        // Read in pieces, so a corrupt length runs out of stream before it runs out of memory
+        std::string key;
+        char buffer[4096];
+        while (length > 0 && is) {
+            size_t part = size_t(std::min<uint64_t>(length, sizeof buffer));
+            is.read(buffer, std::streamsize(part));
+            key.append(buffer, size_t(is.gcount()));
+            length -= part;
+        }
+        return key;
+    } else {
+        static_assert(std::is_trivially_copyable_v<Key>, "Only strings and trivially copyable keys can be serialized");
+        Key key;
+        is.read(reinterpret_cast<char *>(&key), sizeof key);
+        return key;
+    }
+}
+
+//-------------------------------------------------------
+// Name: serialize
+// Writes the pilots, remap table and keys in binary so the build can be skipped next time
+//---------------------------------------------------------
+template<class Key, class Hash>
+void PerfectHashTable<Key, Hash>::serialize(std::ostream &os) const {
+
+    uint64_t header[3] = {keyCount, slotCount, pilots.size()};
+    os.write(reinterpret_cast<const char *>(header), sizeof header);
+    os.write(reinterpret_cast<const char *>(pilots.data()), std::streamsize(pilots.size() * sizeof(uint32_t)));
+
+    for (size_t slot : remap) {
+        uint64_t value = slot;
+        os.write(reinterpret_cast<const char *>(&value), sizeof value);
+    }
+    for (const Key &key : keys) {
+        writeKey(os, key);
+    }
+}
+
+//-------------------------------------------------------
+// Name: deserialize
+// Reads a table written by serialize. The header is checked against what build would have made
+// before anything is allocated, and a bad header, an out of range value or a stream that runs out
+// early all throw runtime_error. The hasher isn't part of the stream, so pass the one the table
+// was built with if it carries a seed.
+//---------------------------------------------------------
+template<class Key, class Hash>
+PerfectHashTable<Key, Hash> PerfectHashTable<Key, Hash>::deserialize(std::istream &is, const Hash &hashFunction) {
+
+    PerfectHashTable result;
+    result.hasher = hashFunction;
+    uint64_t header[3] = {0, 0, 0};
+    is.read(reinterpret_cast<char *>(header), sizeof header);
+    if (!is) {
+        throw std::runtime_error("Perfect hashtable stream is truncated!");
+    }
+
+    uint64_t keyCount = header[0];
+    if (keyCount > uint64_t(SIZE_MAX / 2) || header[1] != std::max(keyCount, uint64_t(double(keyCount) / slotLoad))
+        || header[2] != keyCount / bucketLoad + 1) {
+        throw std::runtime_error("Perfect hashtable stream has a bad header!");
+    }
+    result.keyCount = size_t(keyCount);
+    result.slotCount = size_t(header[1]);
+
+    // Everything is read one value at a time, so a header claiming more than the stream holds fails
+    // on the read instead of allocating for it first
+    for (uint64_t i = 0; i < header[2] && is; i++) {
+        uint32_t pilot = 0;
+        is.read(reinterpret_cast<char *>(&pilot), sizeof pilot);
+        if (pilot >= maxPilot) {
+            throw std::runtime_error("Perfect hashtable stream has a bad pilot!");
+        }
+        result.pilots.push_back(pilot);
+    }
+    for (size_t i = result.keyCount; i < result.slotCount && is; i++) {
+        uint64_t value = 0;
+        is.read(reinterpret_cast<char *>(&value), sizeof value);
+        if (value >= keyCount) {
+            throw std::runtime_error("Perfect hashtable stream has a bad remap entry!");
+        }
+        result.remap.push_back(size_t(value));
+    }
+    for (size_t i = 0; i < result.keyCount && is; i++) {
+        result.keys.push_back(readKey(is));
+    }
+
+    if (!is) {
+        throw std::runtime_error("Perfect hashtable stream is truncated!");
+    }
+    return result;
+}
+
+#endif  // HASHTABLE_PERFECT_H
@@ -0,0 +1,403 @@
+/*****************************************
+** File:    hashtable_pool.h
+** Project: CSCE 221 Lab 6 Spring 2022
+** Author:  Joshua Hillis
+** Date:    04/12/2022
+** Section: 512
+** E-mail:  joshuahillis292002@tamu.edu
+**
+** This is the header file for the work-stealing thread pool the hashtables use for their bulk
+** operations. Every worker owns a Chase-Lev deque: it pushes and pops tasks at the bottom of its
+** own deque, and when that runs dry it steals from the top of someone else's. A parallel_for is
+** split lazily, each task hands its right half back to the pool before working on its left half,
+** so idle threads always have a big piece to steal. Workers with nothing to steal park on a
+** condition variable until more tasks are pushed.
+**
+***********************************************/
+
+#ifndef HASHTABLE_POOL_H
+#define HASHTABLE_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "hashtable_parallel.h"
+
+class WorkStealingPool {
+private:
+    struct Job;
+
+    // A piece [begin, end) of a parallel_for. They're handed out from the job's own array, so
+    // splitting never allocates.
+    struct Task {
+        Job *job;
+        size_t begin;
+        size_t end;
+    };
+
+    struct Job {
+        void (*invoke)(void *fn, size_t begin, size_t end);
+        void *fn;
+        size_t grain;
+        // How many items haven't been run yet, the job is done once this reaches 0
+        std::atomic<size_t> remaining;
+        std::vector<Task> tasks;
+        std::atomic<size_t> nextTask;
+    };
+
+    // Chase and Lev's deque, with the memory orders from Le, Pop, Cohen and Zappa Nardelli's C11
+    // version. Only the owner calls push and pop, anyone may call steal. The ring doubles when it
+    // fills up, and old rings are kept until the deque goes away since a thief may still be
+    // reading one.
+    class TaskDeque {
+    public:
+        TaskDeque();
+
+        void push(Task *task);
+
+        Task *pop();
+
+        Task *steal();
+
+    private:
+        struct Ring {
+            std::vector<std::atomic<Task *>> slots;
+            int64_t mask;
+
+            explicit Ring(size_t capacity) : slots(capacity), mask(int64_t(capacity) - 1) {}
+
+            Task *get(int64_t index) const { return slots[size_t(index & mask)].load(std::memory_order_relaxed); }
+
+            void put(int64_t index, Task *task) { slots[size_t(index & mask)].store(task, std::memory_order_relaxed); }
+        };
+
+        std::atomic<int64_t> top;
+        std::atomic<int64_t> bottom;
+        std::atomic<Ring *> ring;
+        std::vector<std::unique_ptr<Ring>> rings;
+    };
+
+    // Deque 0 belongs to whichever outside thread is running a parallel_for, the rest to workers
+    std::vector<std::unique_ptr<TaskDeque>> deques;
+    std::vector<std::thread> workers;
+    // Only one outside thread at a time can use deque 0
+    std::mutex callerMutex;
+
+    // Parking: a worker remembers pushes before its last look for work, and only sleeps if no
+    // push happened since
+    std::mutex parkMutex;
+    std::condition_variable parkSignal;
+    std::atomic<unsigned> pushes;
+    std::atomic<unsigned> sleeping;
+    std::atomic<bool> stopping;
+
+    // Which pool, if any, the current thread is a worker of, and its deque
+    static inline thread_local WorkStealingPool *currentPool = nullptr;
+    static inline thread_local size_t currentIndex = 0;
+
+    void workerLoop(size_t self);
+
+    void push(size_t self, Task *task);
+
+    Task *findTask(size_t self);
+
+    void run(size_t self, Task *task);
+
+public:
+    explicit WorkStealingPool(unsigned threads = defaultThreadCount());
+
+    WorkStealingPool(const WorkStealingPool &other) = delete;
+
+    WorkStealingPool &operator=(const WorkStealingPool &other) = delete;
+
+    ~WorkStealingPool();
+
+    unsigned thread_count() const;
+
+    template<class Fn>
+    void parallel_for(size_t count, size_t grain, Fn fn);
+
+    static WorkStealingPool &shared();
+};
+
+//-------------------------------------------------------
+// Name: TaskDeque Constructor
+// Starts with room for 64 tasks, lazy splitting rarely needs more than a few dozen
+//---------------------------------------------------------
+inline WorkStealingPool::TaskDeque::TaskDeque() : top(0), bottom(0) {
+    rings.push_back(std::make_unique<Ring>(64));
+    ring.store(rings.back().get(), std::memory_order_relaxed);
+}
+
+//-------------------------------------------------------
+// Name: TaskDeque::push
+// Adds a task at the bottom, growing the ring first if it's full. Owner only.
+//---------------------------------------------------------
+inline void WorkStealingPool::TaskDeque::push(Task *task) {
+
+    int64_t b = bottom.load(std::memory_order_relaxed);
+    int64_t t = top.load(std::memory_order_acquire);
+    Ring *current = ring.load(std::memory_order_relaxed);
+
+    if (b - t > current->mask) {
+        rings.push_back(std::make_unique<Ring>(current->slots.size() * 2));
+        Ring *grown = rings.back().get();
+        for (int64_t i = t; i < b; i++) {
+            grown->put(i, current->get(i));
+        }
+        ring.store(grown, std::memory_order_release);
+        current = grown;
+    }
+
+    current->put(b, task);
+    bottom.store(b + 1, std::memory_order_release);
+}
+
+//-------------------------------------------------------
+// Name: TaskDeque::pop
+// Takes the task at the bottom, the one pushed last. Only the last task left can be contended,
+// and then whoever moves top first gets it. Owner only.
+//---------------------------------------------------------
+inline WorkStealingPool::Task *WorkStealingPool::TaskDeque::pop() {
+
+    int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+    Ring *current = ring.load(std::memory_order_relaxed);
+    bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = top.load(std::memory_order_relaxed);
+
+    if (t > b) {
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    Task *task = current->get(b);
+    if (t == b) {
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            task = nullptr;
+        }
+        bottom.store(b + 1, std::memory_order_relaxed);
+    }
+    return task;
+}
+
+//-------------------------------------------------------
+// Name: TaskDeque::steal
+// Takes the task at the top, the oldest and so usually the biggest. Returns null when the deque
+// is empty or another thread got there first.
+//---------------------------------------------------------
+inline WorkStealingPool::Task *WorkStealingPool::TaskDeque::steal() {
+
+    int64_t t = top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t b = bottom.load(std::memory_order_acquire);
+
+    if (t >= b) {
+        return nullptr;
+    }
+
+    Task *task = ring.load(std::memory_order_acquire)->get(t);
+    if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+        return nullptr;
+    }
+    return task;
+}
+
+//-------------------------------------------------------
+// Name: Constructor
+// Starts threads - 1 workers, the thread calling parallel_for makes up the last one
+//---------------------------------------------------------
+inline WorkStealingPool::WorkStealingPool(unsigned threads) : pushes(0), sleeping(0), stopping(false) {
+
+    threads = std::max(1u, threads);
+    for (unsigned i = 0; i < threads; i++) {
+        deques.push_back(std::make_unique<TaskDeque>());
+    }
+    for (unsigned i = 1; i < threads; i++) {
+        workers.emplace_back(&WorkStealingPool::workerLoop, this, size_t(i));
+    }
+}
+
+//-------------------------------------------------------
+// Name: Destructor
+// Wakes every parked worker and waits for them to exit
+//---------------------------------------------------------
+inline WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(parkMutex);
+        stopping.store(true);
+    }
+    parkSignal.notify_all();
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+}
+
+//-------------------------------------------------------
+// Name: thread_count
+// Returns how many threads run a parallel_for, counting the one that calls it
+//---------------------------------------------------------
+inline unsigned WorkStealingPool::thread_count() const {
+    return unsigned(deques.size());
+}
+
+//-------------------------------------------------------
+// Name: shared
+// The pool the hashtables use, with one thread per hardware thread. It's started the first time
+// it's needed.
+//---------------------------------------------------------
+inline WorkStealingPool &WorkStealingPool::shared() {
+    static WorkStealingPool pool;
+    return pool;
+}
+
+//-------------------------------------------------------
+// Name: parallel_for
+// Calls fn(begin, end) on pieces of [0, count) no bigger than grain, on every thread of the pool,
+// and returns once all of them are done. fn is called from several threads at once and must not
+// throw. It can be called from inside another parallel_for on the same pool.
+//---------------------------------------------------------
+template<class Fn>
+void WorkStealingPool::parallel_for(size_t count, size_t grain, Fn fn) {
+
+    grain = std::max<size_t>(1, grain);
+    if (count <= grain || thread_count() == 1) {
+        for (size_t begin = 0; begin < count; begin += grain) {
+            fn(begin, std::min(count, begin + grain));
+        }
+        return;
+    }
+
+    // Halving down to grain makes fewer than 2 * count / grain pieces
+    Job job;
+    job.invoke = [](void *function, size_t begin, size_t end) {
+        (*static_cast<Fn *>(function))(begin, end);
+    };
+    job.fn = &fn;
+    job.grain = grain;
+    job.remaining.store(count);
+    job.tasks.resize(2 * (count / grain) + 2);
+    job.nextTask.store(1);
+    job.tasks[0] = Task{&job, 0, count};
+
+    // A worker already has a deque, anyone else borrows deque 0 (and counts as one of our threads
+    // until we're done, so a nested parallel_for doesn't wait for deque 0 again)
+    std::unique_lock<std::mutex> callerLock;
+    WorkStealingPool *outerPool = currentPool;
+    size_t outerIndex = currentIndex;
+    if (currentPool != this) {
+        callerLock = std::unique_lock<std::mutex>(callerMutex);
+        currentPool = this;
+        currentIndex = 0;
+    }
+    size_t self = currentIndex;
+
+    // Help out, with this job or any other, until every piece of this one has run
+    run(self, &job.tasks[0]);
+    while (job.remaining.load(std::memory_order_acquire) != 0) {
+        Task *task = findTask(self);
+        if (task != nullptr) {
+            run(self, task);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    currentPool = outerPool;
+    currentIndex = outerIndex;
+}
+
+//-------------------------------------------------------
+// Name: run
+// Runs a task, first pushing its right half back to the pool until what's left fits in a grain
+//---------------------------------------------------------
+inline void WorkStealingPool::run(size_t self, Task *task) {
+
+    Job *job = task->job;
+    size_t begin = task->begin;
+    size_t end = task->end;
+    while (end - begin > job->grain) {
+        size_t middle = begin + (end - begin) / 2;
+        Task *right = &job->tasks[job->nextTask.fetch_add(1)];
+        *right = Task{job, middle, end};
+        push(self, right);
+        end = middle;
+    }
+
+    job->invoke(job->fn, begin, end);
+    job->remaining.fetch_sub(end - begin, std::memory_order_acq_rel);
+}
+
+//-------------------------------------------------------
+// Name: push
+// Adds a task to our own deque and wakes a parked worker to come and steal it
+//---------------------------------------------------------
+inline void WorkStealingPool::push(size_t self, Task *task) {
+    deques[self]->push(task);
+    pushes.fetch_add(1);
+    if (sleeping.load() > 0) {
+        std::lock_guard<std::mutex> lock(parkMutex);
+        parkSignal.notify_one();
+    }
+}
+
+//-------------------------------------------------------
+// Name: findTask
+// Our own newest task if we have one, otherwise the oldest task of the first deque we can steal from
+//---------------------------------------------------------
+inline WorkStealingPool::Task *WorkStealingPool::findTask(size_t self) {
+
+    Task *task = deques[self]->pop();
+    for (size_t i = 1; task == nullptr && i < deques.size(); i++) {
+        task = deques[(self + i) % deques.size()]->steal();
+    }
+    return task;
+}
+
+//-------------------------------------------------------
+// Name: workerLoop
+// Runs tasks until the pool shuts down, parking whenever there's nothing left to steal
+//---------------------------------------------------------
+inline void WorkStealingPool::workerLoop(size_t self) {
+
+    currentPool = this;
+    currentIndex = self;
+    while (true) {
+        unsigned seen = pushes.load();
+        Task *task = findTask(self);
+        if (task != nullptr) {
+            run(self, task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(parkMutex);
+        sleeping.fetch_add(1);
+        parkSignal.wait(lock, [&]() {
+            return stopping.load() || pushes.load() != seen;
+        });
+        sleeping.fetch_sub(1);
+        if (stopping.load()) {
+            return;
+        }
+    }
+}
+
+//-------------------------------------------------------
+// Name: forEachChunk
+// Calls fn(begin, end) on chunks covering [0, count) with pool.parallel_for. There are about 16
+// chunks per thread, so a thread that gets the quick chunks (empty buckets, say) just steals
+// more of them, but none so small that handing it out costs more than walking it. A range that
+// makes a single chunk runs on the calling thread.
+//---------------------------------------------------------
+template<class Fn>
+void forEachChunk(WorkStealingPool &pool, size_t count, Fn fn) {
+    size_t chunkSize = std::max<size_t>(1024, count / (size_t(pool.thread_count()) * 16));
+    pool.parallel_for(count, chunkSize, fn);
+}
+
+#endif  // HASHTABLE_POOL_H
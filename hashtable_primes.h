@@ -0,0 +1,85 @@
+/*****************************************
+** File:    hashtable_primes.h
+** Project: CSCE 221 Lab 6 Spring 2022
+** Author:  Joshua Hillis
+** Date:    04/12/2022
+** Section: 512
+** E-mail:  joshuahillis292002@tamu.edu
+**
+** This is the header file for the prime number helpers every hashtable uses to pick its bucket
+** or cell count, and for the quadratic probing that relies on those counts being prime. They're
+** constexpr, so the compile-time table sizes itself and probes with them too.
+**
+***********************************************/
+
+#ifndef HASHTABLE_PRIMES_H
+#define HASHTABLE_PRIMES_H
+
+#include <cstddef>
+
+struct HashPrimes {
+    //-------------------------------------------------------
+    // Name: isPrime
+    // Determines whether a given integer is prime or not
+    //---------------------------------------------------------
+    static constexpr bool isPrime(size_t count) {
+
+        // Check to get simple cases out of the way first
+        if (count == 2 || count == 3) {
+            return true;
+        }
+        if (count <= 1 || count % 2 == 0 || count % 3 == 0) {
+            return false;
+        }
+
+        // Every prime past 3 is 6k - 1 or 6k + 1, so only those need checking as factors
+        for (size_t i = 5; i * i <= count; i += 6) {
+            if (count % i == 0 || count % (i + 2) == 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    //-------------------------------------------------------
+    // Name: nextPrime
+    // Finds the next prime number at or above a given integer
+    //---------------------------------------------------------
+    static constexpr size_t nextPrime(size_t count) {
+
+        if (count <= 1) {
+            return 2;
+        }
+
+        size_t returnPrime = count;
+        while (!isPrime(returnPrime)) {
+            returnPrime += 1;
+        }
+        return returnPrime;
+    }
+};
+
+//-------------------------------------------------------
+// Name: quadraticProbe
+// Probes home, home + 1, home + 4, home + 9, ... wrapping around the count cells, until done(index)
+// is true, and returns that index. With a prime count and at most half the cells in use, the first
+// (count + 1) / 2 probes all land on different cells, so an empty one is always reached.
+//---------------------------------------------------------
+template<class Done>
+constexpr size_t quadraticProbe(size_t home, size_t count, Done done) {
+
+    size_t offset = 1;
+    size_t currentIndex = home;
+    while (!done(currentIndex)) {
+        currentIndex += offset;
+        offset += 2;
+
+        // When we need to loop back around to the beginning of the table
+        if (currentIndex >= count) {
+            currentIndex -= count;
+        }
+    }
+    return currentIndex;
+}
+
+#endif  // HASHTABLE_PRIMES_H
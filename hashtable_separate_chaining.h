@@ -6,7 +6,29 @@
 #include <stdexcept>
 #include <functional>
 #include <iostream>
-
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <type_traits>
+#include "hashtable_frozen.h"
+#include "hashtable_hash.h"
+#include "hashtable_primes.h"
+#include "hashtable_parallel.h"
+#include "hashtable_pool.h"
+
+
+// Detects whether two types can be compared with <, so treeified buckets can order equal hashes by key
+template <class A, class B, class = void>
+struct isLessComparable : std::false_type {};
+
+template <class A, class B>
+struct isLessComparable<A, B, std::void_t<decltype(std::declval<const A&>() < std::declval<const B&>())>> : std::true_type {};
 
 template <class Key, class Hash=std::hash<Key>>
 class HashTable {
@@ -18,26 +40,172 @@ public:
     using size_type = size_t;
 
 private:
-    // A vector containing the lists
-    std::vector<std::list<Key>> *table;
+    // Each list node keeps the key's full hash next to it, so chain walks can skip keys whose hash
+    // differs without calling operator==, and rehash never has to call the hasher again
+    struct node {
+        Key key;
+        size_t hashCode;
+    };
+
+    using nodeIterator = typename std::list<node>::iterator;
+
+    // Like Java's HashMap, a bucket whose chain grows past treeifyThreshold gets a sorted index of
+    // its nodes (by hash, then by key when Key has operator<) so it can be binary searched, and
+    // loses it again once the chain shrinks to untreeifyThreshold. The gap avoids flip-flopping.
+    static constexpr size_t treeifyThreshold = 8;
+    static constexpr size_t untreeifyThreshold = 6;
+    // Tables with at least this many buckets rehash in parallel, each task moving the nodes of at
+    // least rangeBuckets old buckets
+    static constexpr size_t parallelRehashThreshold = size_t(1) << 16;
+    static constexpr size_t rangeBuckets = size_t(1) << 13;
+
+    // A vector containing the lists. A default constructed table points at the shared emptyTable()
+    // instead of its own, and only allocates once the first key is inserted.
+    std::vector<std::list<node>> *table;
+    // With lazyClear on, make_empty just bumps generation. A bucket whose stamp is behind it still
+    // holds keys from before the clear: lookups treat it as empty, and the first insert or remove
+    // that touches it frees the old nodes. With it off (the default) there are no stamps at all,
+    // generation stays 0 and make_empty clears every bucket right away.
+    bool lazyClear;
+    std::vector<unsigned int> stamps;
+    unsigned int generation;
+    // Sorted indexes for the treeified buckets, keyed by bucket number
+    std::map<size_t, std::vector<nodeIterator>> treeBins;
     int currentSize;
     int bucketCount;
-    int maxLoad;
-
-    // Helper functions to determine if a number is prime, or find the next prime number
-    int nextPrime(int count);
-    bool isPrime(int count);
+    float maxLoad;
+    // Removing keys until the load factor drops under minLoad shrinks the table, but never below
+    // minBuckets (the size asked for at construction or by reserve). Shrinking aims for half of
+    // maxLoad, so the table has to grow or shrink a lot before it resizes again.
+    float minLoad;
+    int minBuckets;
+    // Our own copy of the hasher, so a seeded hasher gets a different seed in every table
+    Hash hasher;
+
+    bool isStale(size_t n) const;
+    std::list<node>& bucketAt(size_t n);
+    const std::list<node>& bucketAt(size_t n) const;
+    static std::vector<std::list<node>>* emptyTable();
+    void allocateTable();
+    void releaseTable();
+    void resetStamps();
+    void copyBuckets(const HashTable& other);
+
+    // Lookup helpers shared by the key_type and the transparent overloads
+    template<class K> size_t hashIndex(const K& key) const;
+    template<class K> nodeIterator findNode(const K& key, size_t hashCode) const;
+    template<class K> typename std::vector<nodeIterator>::iterator treeLowerBound(std::vector<nodeIterator>& tree, const K& key, size_t hashCode) const;
+    static bool treeLess(const nodeIterator& lhs, const nodeIterator& rhs);
+    void treeify(size_t n);
+    void rebuildTreeBins();
+    template<class K> bool containsKey(const K& key) const;
+    template<class K> bool containsHashed(const K& key, size_t hashCode) const;
+    template<class K> size_t removeKey(const K& key);
+    template<class K> void extractKey(const K& key, std::list<node>& holder);
+    bool insertHashed(const value_type& value, size_t hashCode);
+    void linkLast(size_t n);
+    void detachNode(size_t n, nodeIterator itr);
+    void eraseNode(size_t n, nodeIterator itr);
+    size_t hashOf(const node& element) const;
+    std::vector<nodeIterator> findShared(const HashTable& other, WorkStealingPool &pool) const;
+    template<class Drop> void eraseNodes(Drop drop, WorkStealingPool &pool);
+    void shrinkIfSparse();
+    void growFor(size_t count);
+    void rehashOn(size_type count, WorkStealingPool* pool);
+    void spliceInParallel(std::vector<std::list<node>>& newTable, WorkStealingPool& pool);
 
 public:
+    // Owns a key taken out of a table by extract, still in its list node, so it can be inserted
+    // into a table again without allocating or copying the key. Like std::unordered_set's node
+    // handles it can be moved but not copied, and value() lets the key be changed in between.
+    class node_type {
+    public:
+        node_type() : keyChanged(false) {}
+        node_type(node_type&& other) noexcept : keyChanged(other.keyChanged) {
+            holder.splice(holder.end(), other.holder);
+        }
+        node_type& operator=(node_type&& other) noexcept {
+            holder.clear();
+            holder.splice(holder.end(), other.holder);
+            keyChanged = other.keyChanged;
+            return *this;
+        }
+
+        [[nodiscard]] bool empty() const { return holder.empty(); }
+        explicit operator bool() const { return !holder.empty(); }
+        Key& value() { keyChanged = true; return holder.front().key; }
+        const Key& value() const { return holder.front().key; }
+
+    private:
+        friend class HashTable;
+
+        // Empty, or the one node that was extracted
+        std::list<node> holder;
+        // Set once value() has handed out the key for changing, since the cached hash may be wrong now
+        bool keyChanged;
+    };
+
+    // Forward iterator over every key, bucket by bucket. Keys can't be changed in place, since that
+    // would move them to another bucket, so iterator and const_iterator are the same type.
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Key;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Key*;
+        using reference = const Key&;
+
+        const_iterator() : owner(nullptr), bucketIndex(0) {}
+
+        reference operator*() const { return position->key; }
+        pointer operator->() const { return &position->key; }
+
+        const_iterator& operator++() {
+            ++position;
+            if (position == bucketEnd) {
+                skipEmptyBuckets();
+            }
+            return *this;
+        }
+
+        const_iterator operator++(int) {
+            const_iterator old = *this;
+            ++*this;
+            return old;
+        }
+
+        bool operator==(const const_iterator& other) const {
+            return bucketIndex == other.bucketIndex && (owner == nullptr || bucketIndex == size_t(owner->bucketCount) || position == other.position);
+        }
+        bool operator!=(const const_iterator& other) const { return !(*this == other); }
+
+    private:
+        friend class HashTable;
+
+        const HashTable* owner;
+        size_t bucketIndex;
+        // Where we are in the current bucket, and that bucket's end so ++ doesn't have to look it up
+        typename std::list<node>::const_iterator position;
+        typename std::list<node>::const_iterator bucketEnd;
+
+        const_iterator(const HashTable* table, size_t n);
+        void skipEmptyBuckets();
+    };
+    using iterator = const_iterator;
+
     HashTable();
     HashTable(const HashTable& other);
     ~HashTable();
     HashTable& operator=(const HashTable& other);
     explicit HashTable(size_type buckets);
+    HashTable(expected_size_t, size_type count);
     [[nodiscard]] bool is_empty() const;
     size_t size() const;
     void make_empty();
     bool insert(const value_type& value);
+    template<class InputIt> void insert(InputIt first, InputIt last);
+    bool insert(node_type&& nh);
+    node_type extract(const key_type& key);
     size_t remove(const key_type& key);
     bool contains(const key_type& key);
     size_t bucket_count() const;
@@ -46,8 +214,38 @@ public:
     float load_factor() const;
     float max_load_factor() const;
     void max_load_factor(float mlf);
+    float min_load_factor() const;
+    void min_load_factor(float mlf);
+    bool lazy_clear() const;
+    void lazy_clear(bool enabled);
     void rehash(size_type count);
+    void rehash(size_type count, WorkStealingPool& pool);
+    void reserve(size_type count);
+    void shrink_to_fit();
     void print_table(std::ostream& os=std::cout) const;
+    std::vector<Key> keys() const;
+    const_iterator begin() const;
+    const_iterator end() const;
+    template<class Fn> void for_each(Fn fn) const;
+    template<class Fn> void parallel_for_each(Fn fn, WorkStealingPool& pool=WorkStealingPool::shared()) const;
+    template<class Pred> size_t parallel_count_if(Pred pred, WorkStealingPool& pool=WorkStealingPool::shared()) const;
+    template<class Fn> uint64_t scan(uint64_t cursor, size_t count, Fn fn) const;
+    hash hash_function() const;
+    template<class RandomIt> void build(RandomIt first, RandomIt last, unsigned threads=defaultThreadCount());
+    void union_with(const HashTable& other);
+    void merge(HashTable& other);
+    void merge(HashTable&& other);
+    void intersect_with(const HashTable& other, WorkStealingPool& pool=WorkStealingPool::shared());
+    void difference_with(const HashTable& other, WorkStealingPool& pool=WorkStealingPool::shared());
+    bool is_subset_of(const HashTable& other, WorkStealingPool& pool=WorkStealingPool::shared()) const;
+
+    // Transparent overloads, only available when Hash defines is_transparent (e.g. StringHash),
+    // so a HashTable<std::string, StringHash> can be searched with a string_view or const char*
+    template<class K, class H=Hash, class=typename H::is_transparent> bool contains(const K& key);
+    template<class K, class H=Hash, class=typename H::is_transparent> size_t remove(const K& key);
+    template<class K, class H=Hash, class=typename H::is_transparent> node_type extract(const K& key);
+    template<class K, class H=Hash, class=typename H::is_transparent> size_t bucket(const K& key) const;
+    FrozenHashTable<Key, Hash> freeze() const;
 
     // Optional
     // HashTable(HashTable&& other);
@@ -55,41 +253,46 @@ public:
     // bool insert(value_type&& value);
 };
 
-// Default constructor, initializes a hash table with 11 buckets
+// Default constructor, initializes a hash table with 11 buckets. Nothing is allocated until the
+// first insert, until then the table shares the read-only emptyTable().
 template<class Key, class Hash>
 HashTable<Key, Hash>::HashTable() {
-    // Initialize our default values and create the hash table
+    // Initialize our default values, the buckets come later
     bucketCount = 11;
     currentSize = 0;
     maxLoad = 1;
-    table = new std::vector<std::list<Key>>[bucketCount];
-
-    // Initialize the lists within the vector
-    for (int i = 0; i < bucketCount; i++) {
-        table->push_back(std::list<Key>());
-    }
+    minLoad = 0.25;
+    minBuckets = bucketCount;
+    lazyClear = false;
+    generation = 0;
+    table = emptyTable();
 }
 
 // Copy constructor, makes one has table identical to the other
 template<class Key, class Hash>
 HashTable<Key, Hash>::HashTable(const HashTable &other){
 
-    // Copy the variables over
+    // Copy the variables over, including the hasher since the buckets depend on its seed
     bucketCount = other.bucketCount;
     maxLoad = other.maxLoad;
+    minLoad = other.minLoad;
+    minBuckets = other.minBuckets;
     currentSize = other.currentSize;
-    table = new std::vector<std::list<Key>>[bucketCount];
+    lazyClear = other.lazyClear;
+    hasher = other.hasher;
 
-    for (int i = 0; i < other.bucketCount; i++) {
-        // Use the list's copy assignment to copy the whole list
-        table->push_back(other.table->at(i));
-    }
+    // A copy of a table that never allocated doesn't allocate either
+    table = emptyTable();
+    copyBuckets(other);
+
+    // The other table's tree bins point into its own lists, so build ours from scratch
+    rebuildTreeBins();
 }
 
 template<class Key, class Hash>
 HashTable<Key, Hash>::~HashTable() {
-    // We created a vector of lists, so we need to delete[]
-    delete[] table;
+    // We created a single vector of lists, so a plain delete frees it
+    releaseTable();
 }
 
 // Copy assignment operator, used to copy hashtables whilst also checking for self assignment
@@ -104,12 +307,17 @@ HashTable<Key, Hash> &HashTable<Key, Hash>::operator=(const HashTable &other) {
     // Copy the variables and all of the lists
     bucketCount = other.bucketCount;
     maxLoad = other.maxLoad;
+    minLoad = other.minLoad;
+    minBuckets = other.minBuckets;
     currentSize = other.currentSize;
-
-    for (int i = 0; i < other.bucketCount; i++) {
-        // Use the list's copy assignment to copy the whole list
-        table->push_back(other.table->at(i));
-    }
+    lazyClear = other.lazyClear;
+    hasher = other.hasher;
+
+    // Replace our lists with copies of theirs, never writing into the shared empty table
+    releaseTable();
+    table = emptyTable();
+    copyBuckets(other);
+    rebuildTreeBins();
     return *this;
 }
 
@@ -121,26 +329,27 @@ HashTable<Key, Hash>::HashTable(HashTable::size_type buckets) {
     bucketCount = buckets;
     currentSize = 0;
     maxLoad = 1;
-    table = new std::vector<std::list<Key>>[bucketCount];
+    minLoad = 0.25;
+    minBuckets = bucketCount;
+    lazyClear = false;
+    generation = 0;
 
-    // Initialize the lists within the vector
-    for (int i = 0; i < bucketCount; i++) {
-        table->push_back(std::list<value_type>());
-    }
+    // Create the vector with an empty list in every bucket
+    table = new std::vector<std::list<node>>(bucketCount);
+}
+
+// Constructor for a table that is about to receive count keys, sized so none of them cause a rehash
+template<class Key, class Hash>
+HashTable<Key, Hash>::HashTable(expected_size_t, HashTable::size_type count) : HashTable() {
+    reserve(count);
 }
 
 // Function to see if the hashtable is empty
 template<class Key, class Hash>
 bool HashTable<Key, Hash>::is_empty() const {
 
-    // Iterate through each bucket and see if it contains anything, if it does, return false
-    for (int i = 0; i < bucketCount; i++){
-        if (table->at(i).empty()) {
-            return false;
-        }
-    }
-    // If we've reached this code, then none of the buckets had a list
-    return true;
+    // currentSize tracks every insert and remove, so there's no need to look at the buckets
+    return currentSize == 0;
 }
 
 // Function to return the number of values currently in the table
@@ -149,93 +358,436 @@ size_t HashTable<Key, Hash>::size() const {
     return currentSize;
 }
 
-// Function to completely empty out the hash table
+// Function to completely empty out the hash table. With lazy_clear on this takes constant time:
+// every bucket becomes stale at once, and each one frees its old nodes the next time it's changed.
 template<class Key, class Hash>
 void HashTable<Key, Hash>::make_empty() {
 
-    // For all of the lists in our vector, clear that list
-    for(int i = 0; i < table->size(); i++) {
-        table->at(i).clear();
+    // Every bucket is already empty, so there's nothing to clear
+    if (currentSize == 0) {
+        return;
     }
+
+    treeBins.clear();
     currentSize = 0;
+
+    // Clear every list for real unless we're lazy, or once the counter is about to wrap
+    if (!lazyClear || generation == UINT_MAX) {
+        for(unsigned int i = 0; i < table->size(); i++) {
+            table->at(i).clear();
+        }
+        resetStamps();
+        return;
+    }
+    generation += 1;
+}
+
+// Returns whether bucket n still holds keys from before the last make_empty. Nothing can be stale
+// in generation 0, which is also the only one the shared empty table is in.
+template<class Key, class Hash>
+bool HashTable<Key, Hash>::isStale(size_t n) const {
+    return generation != 0 && stamps[n] != generation;
+}
+
+// Returns bucket n for changing it, first emptying it if it's stale
+template<class Key, class Hash>
+std::list<typename HashTable<Key, Hash>::node> &HashTable<Key, Hash>::bucketAt(size_t n) {
+
+    std::list<node> &hashList = table->at(n);
+    if (isStale(n)) {
+        hashList.clear();
+        stamps[n] = generation;
+    }
+    return hashList;
+}
+
+// Returns bucket n for reading. A stale bucket reads as one of the shared empty table's lists, so
+// lookups never write to the table and can run alongside each other.
+template<class Key, class Hash>
+const std::list<typename HashTable<Key, Hash>::node> &HashTable<Key, Hash>::bucketAt(size_t n) const {
+    if (isStale(n)) {
+        return emptyTable()->front();
+    }
+    return table->at(n);
+}
+
+// The buckets every default constructed table starts out sharing. It's never written to, a table
+// gets its own buckets from allocateTable before its first insert.
+template<class Key, class Hash>
+std::vector<std::list<typename HashTable<Key, Hash>::node>> *HashTable<Key, Hash>::emptyTable() {
+    static std::vector<std::list<node>> sentinel(11);
+    return &sentinel;
+}
+
+// Gives a table that is still sharing the empty table its own buckets
+template<class Key, class Hash>
+void HashTable<Key, Hash>::allocateTable() {
+    if (table == emptyTable()) {
+        table = new std::vector<std::list<node>>(bucketCount);
+        resetStamps();
+    }
+}
+
+// Frees the table's buckets, unless they're the shared empty ones
+template<class Key, class Hash>
+void HashTable<Key, Hash>::releaseTable() {
+    if (table != emptyTable()) {
+        delete table;
+    }
+}
+
+// Starts generation 0 over with every bucket current, for when none of them hold stale keys.
+// Only a lazy table keeps a stamp per bucket.
+template<class Key, class Hash>
+void HashTable<Key, Hash>::resetStamps() {
+    generation = 0;
+    stamps.assign(lazyClear ? table->size() : 0, generation);
+}
+
+// Gives a table sharing the empty table copies of other's buckets. Stale buckets are left empty
+// instead of being copied, so the copy starts over in generation 0.
+template<class Key, class Hash>
+void HashTable<Key, Hash>::copyBuckets(const HashTable &other) {
+
+    if (other.table != emptyTable()) {
+        table = new std::vector<std::list<node>>(other.table->size());
+        for (unsigned int i = 0; i < table->size(); i++) {
+            if (!other.isStale(i)) {
+                table->at(i) = other.table->at(i);
+            }
+        }
+    }
+    resetStamps();
 }
 
 // Inserts the given value into the hash table, and rehashes if the maximum load factor is exceeded
 // WORKING
 template<class Key, class Hash>
 bool HashTable<Key, Hash>::insert(const value_type &value) {
+    return insertHashed(value, hasher(value));
+}
 
-    size_t hash_value = Hash{}(value);
-    hash_value = hash_value % bucketCount;
+// Inserts a value whose hash has already been worked out, so union_with can reuse cached hashes
+template<class Key, class Hash>
+bool HashTable<Key, Hash>::insertHashed(const value_type &value, size_t hashCode) {
 
-    std::list<Key> hashList;
+    allocateTable();
 
-    // Check if the table exists at that index, and use an empty list if it doesn't.
-    if (table->size() > hash_value) {
-        hashList = table->at(hash_value);
-    } else {
-        hashList = std::list<Key>();
+    size_t n = homeIndex(hashCode, bucketCount);
+    std::list<node> &hashList = bucketAt(n);
+
+    // Search the bucket in place, and return false if there's a duplicate item
+    if (findNode(value, hashCode) != hashList.end()) {
+        return false;
+    }
+
+    // If we've passed the loop, we can insert the item along with its hash
+    hashList.push_back(node{value, hashCode});
+    linkLast(n);
+    return true;
+}
+
+// Inserts the node held by nh, moving it into its bucket rather than copying the key. Returns
+// false and leaves the node in nh if the key is already in the table.
+template<class Key, class Hash>
+bool HashTable<Key, Hash>::insert(node_type &&nh) {
+
+    if (nh.empty()) {
+        return false;
     }
-    // Use the find function to check all elements from the beginning to the end of the list
-    if (std::find(std::begin(hashList), std::end(hashList), value) != std::end(hashList)){
-        // Return false if there's a duplicate item
+
+    allocateTable();
+
+    // The cached hash is only any good if nobody changed the key and every table hashes alike
+    node &element = nh.holder.front();
+    size_t hashCode = nh.keyChanged ? hasher(element.key) : hashOf(element);
+    size_t n = homeIndex(hashCode, bucketCount);
+    std::list<node> &hashList = bucketAt(n);
+    if (findNode(element.key, hashCode) != hashList.end()) {
         return false;
     }
 
-    // If we've passed the loop, we can insert the item
-    table->at(hash_value).push_back(value);
+    element.hashCode = hashCode;
+    hashList.splice(hashList.end(), nh.holder);
+    nh.keyChanged = false;
+    linkLast(n);
+    return true;
+}
+
+// Accounts for the node just added to the back of bucket n, and rehashes if the maximum load factor is exceeded
+template<class Key, class Hash>
+void HashTable<Key, Hash>::linkLast(size_t n) {
+
+    std::list<node> &hashList = table->at(n);
     currentSize += 1;
 
+    // Keep a treeified bucket's index sorted, or treeify the bucket if it just got too long
+    auto bin = treeBins.find(n);
+    if (bin != treeBins.end()) {
+        auto &tree = bin->second;
+        tree.insert(treeLowerBound(tree, hashList.back().key, hashList.back().hashCode), std::prev(hashList.end()));
+    } else if (hashList.size() > treeifyThreshold) {
+        treeify(n);
+    }
+
     // Check if we need to rehash
     if (load_factor() > maxLoad) {
         rehash(bucketCount * 2);
     }
+}
 
-    return true;
+// Inserts every key in [first, last). When the length of the range can be found without consuming
+// it, the table is grown once up front instead of doubling repeatedly along the way.
+template<class Key, class Hash>
+template<class InputIt>
+void HashTable<Key, Hash>::insert(InputIt first, InputIt last) {
+
+    using category = typename std::iterator_traits<InputIt>::iterator_category;
+    if constexpr (std::is_base_of_v<std::forward_iterator_tag, category>) {
+        growFor(size_t(currentSize) + size_t(std::distance(first, last)));
+    }
+    for (; first != last; ++first) {
+        insert(*first);
+    }
 }
 
 // Checks if an element exists in a hash table and removes it if it does, or does nothing if it's not present
 template<class Key, class Hash>
 size_t HashTable<Key, Hash>::remove(const key_type &key) {
+    return removeKey(key);
+}
 
-    // Hash the key for use
-    size_t hash_value = Hash{}(key);
-    hash_value = hash_value % bucketCount;
+// Transparent version of remove, the key only has to be comparable with Key
+template<class Key, class Hash>
+template<class K, class H, class>
+size_t HashTable<Key, Hash>::remove(const K &key) {
+    return removeKey(key);
+}
 
-    auto & hashList = table->at(hash_value);
-    // Use the find function to check all elements from the beginning to the end of the list
-    auto itr = std::find(std::begin(hashList), std::end(hashList), key);
+// Takes the key's node out of the table and hands it over in a node handle, which is empty if the
+// key isn't there. Nothing is freed, so inserting the handle elsewhere doesn't allocate either.
+template<class Key, class Hash>
+typename HashTable<Key, Hash>::node_type HashTable<Key, Hash>::extract(const key_type &key) {
+    node_type nh;
+    extractKey(key, nh.holder);
+    return nh;
+}
 
-    if (itr == std::end(hashList)) {
+// Transparent version of extract, the key only has to be comparable with Key
+template<class Key, class Hash>
+template<class K, class H, class>
+typename HashTable<Key, Hash>::node_type HashTable<Key, Hash>::extract(const K &key) {
+    node_type nh;
+    extractKey(key, nh.holder);
+    return nh;
+}
+
+// Returns true or false depending on whether the hashtable contains the given value or not
+template<class Key, class Hash>
+bool HashTable<Key, Hash>::contains(const key_type &key) {
+    return containsKey(key);
+}
+
+// Transparent version of contains, the key only has to be comparable with Key
+template<class Key, class Hash>
+template<class K, class H, class>
+bool HashTable<Key, Hash>::contains(const K &key) {
+    return containsKey(key);
+}
+
+// Hashes any key the hasher accepts down to a bucket index
+template<class Key, class Hash>
+template<class K>
+size_t HashTable<Key, Hash>::hashIndex(const K &key) const {
+    return homeIndex(hasher(key), bucketCount);
+}
+
+// Finds an already hashed key in its bucket, or returns the bucket's end() if it isn't there.
+// Short chains are walked, only comparing keys whose cached hash matches; treeified ones are binary searched.
+template<class Key, class Hash>
+template<class K>
+typename HashTable<Key, Hash>::nodeIterator HashTable<Key, Hash>::findNode(const K &key, size_t hashCode) const {
+
+    // The table pointer is const here but not what it points at, so hand out iterators into it.
+    // A stale bucket has nothing current in it.
+    size_t n = homeIndex(hashCode, bucketCount);
+    std::list<node> &hashList = table->at(n);
+    if (isStale(n)) {
+        return hashList.end();
+    }
+
+    if (hashList.size() > untreeifyThreshold) {
+        auto bin = treeBins.find(n);
+        if (bin != treeBins.end()) {
+            auto &tree = const_cast<std::vector<nodeIterator> &>(bin->second);
+            for (auto itr = treeLowerBound(tree, key, hashCode); itr != tree.end() && (*itr)->hashCode == hashCode; ++itr) {
+                if ((*itr)->key == key) {
+                    return *itr;
+                }
+                // With ordered keys the first candidate is the only one that can match
+                if constexpr (isLessComparable<Key, Key>::value && isLessComparable<Key, K>::value) {
+                    break;
+                }
+            }
+            return hashList.end();
+        }
+    }
+
+    for (auto itr = hashList.begin(); itr != hashList.end(); ++itr) {
+        if (itr->hashCode == hashCode && itr->key == key) {
+            return itr;
+        }
+    }
+    return hashList.end();
+}
+
+// Binary searches a tree bin for the first node that isn't ordered before (hashCode, key)
+template<class Key, class Hash>
+template<class K>
+typename std::vector<typename HashTable<Key, Hash>::nodeIterator>::iterator
+HashTable<Key, Hash>::treeLowerBound(std::vector<nodeIterator> &tree, const K &key, size_t hashCode) const {
+
+    return std::lower_bound(tree.begin(), tree.end(), hashCode, [&key](const nodeIterator &element, size_t target) {
+        if (element->hashCode != target) {
+            return element->hashCode < target;
+        }
+        if constexpr (isLessComparable<Key, Key>::value && isLessComparable<Key, K>::value) {
+            return bool(element->key < key);
+        } else {
+            return false;
+        }
+    });
+}
+
+// Ordering used to sort a tree bin, by hash and then by key when keys can be ordered
+template<class Key, class Hash>
+bool HashTable<Key, Hash>::treeLess(const nodeIterator &lhs, const nodeIterator &rhs) {
+    if (lhs->hashCode != rhs->hashCode) {
+        return lhs->hashCode < rhs->hashCode;
+    }
+    if constexpr (isLessComparable<Key, Key>::value) {
+        return bool(lhs->key < rhs->key);
+    } else {
+        return false;
+    }
+}
+
+// Builds the sorted index for bucket n
+template<class Key, class Hash>
+void HashTable<Key, Hash>::treeify(size_t n) {
+
+    std::list<node> &hashList = bucketAt(n);
+    std::vector<nodeIterator> &tree = treeBins[n];
+    tree.clear();
+    tree.reserve(hashList.size());
+    for (auto itr = hashList.begin(); itr != hashList.end(); ++itr) {
+        tree.push_back(itr);
+    }
+    std::sort(tree.begin(), tree.end(), treeLess);
+}
+
+// Throws away every tree bin and treeifies the buckets that are long enough to need one
+template<class Key, class Hash>
+void HashTable<Key, Hash>::rebuildTreeBins() {
+
+    treeBins.clear();
+    for (unsigned int i = 0; i < table->size(); i++) {
+        if (bucketAt(i).size() > treeifyThreshold) {
+            treeify(i);
+        }
+    }
+}
+
+// Searches the key's bucket in place, without copying the list
+template<class Key, class Hash>
+template<class K>
+bool HashTable<Key, Hash>::containsKey(const K &key) const {
+    return containsHashed(key, hasher(key));
+}
+
+// Same as containsKey, for a key whose hash has already been worked out
+template<class Key, class Hash>
+template<class K>
+bool HashTable<Key, Hash>::containsHashed(const K &key, size_t hashCode) const {
+    return findNode(key, hashCode) != table->at(homeIndex(hashCode, bucketCount)).end();
+}
+
+// Erases the key from its bucket if it's there, returning how many keys were removed
+template<class Key, class Hash>
+template<class K>
+size_t HashTable<Key, Hash>::removeKey(const K &key) {
+
+    size_t hashCode = hasher(key);
+    size_t n = homeIndex(hashCode, bucketCount);
+    std::list<node> &hashList = bucketAt(n);
+    nodeIterator itr = findNode(key, hashCode);
+
+    if (itr == hashList.end()) {
         // Return 0, since we didn't remove anything
         return 0;
     }
 
-    // Erase the object and update the current size
-    hashList.erase(itr);
-    currentSize -= 1;
+    eraseNode(n, itr);
+    shrinkIfSparse();
     return 1;
 }
 
-// Returns true or false depending on whether the hashtable contains the given value or not
+// Moves the key's node out of its bucket into an empty holder list, or leaves the holder empty if it isn't there
 template<class Key, class Hash>
-bool HashTable<Key, Hash>::contains(const key_type &key) {
+template<class K>
+void HashTable<Key, Hash>::extractKey(const K &key, std::list<node> &holder) {
 
-    // Hash the key for use
-    size_t hash_value = Hash{}(key);
-    hash_value = hash_value % bucketCount;
+    size_t hashCode = hasher(key);
+    size_t n = homeIndex(hashCode, bucketCount);
+    std::list<node> &hashList = bucketAt(n);
+    nodeIterator itr = findNode(key, hashCode);
 
-    key_type other_value;
-    std::list<Key> hashList = table->at(hash_value);
+    if (itr == hashList.end()) {
+        return;
+    }
+
+    detachNode(n, itr);
+    holder.splice(holder.end(), hashList, itr);
+    shrinkIfSparse();
+}
 
-    while (!hashList.empty()) {
-        if (key == hashList.front()) {
-            return true;
+// Takes a node in bucket n, which can't be stale, out of the bucket's tree bin and the size count.
+// The node itself is left in the list for the caller to erase or splice somewhere else.
+template<class Key, class Hash>
+void HashTable<Key, Hash>::detachNode(size_t n, nodeIterator itr) {
+
+    // Drop the node from the bucket's tree bin, and the bin itself once the chain is short again
+    auto bin = treeBins.find(n);
+    if (bin != treeBins.end()) {
+        auto &tree = bin->second;
+        tree.erase(std::find(treeLowerBound(tree, itr->key, itr->hashCode), tree.end(), itr));
+        if (table->at(n).size() - 1 <= untreeifyThreshold) {
+            treeBins.erase(bin);
         }
-        hashList.pop_front();
     }
-    // If we make it past the above expression, then we've found the element
-    return false;
+    currentSize -= 1;
+}
+
+// Erases a node from bucket n, which can't be stale, without shrinking the table
+template<class Key, class Hash>
+void HashTable<Key, Hash>::eraseNode(size_t n, nodeIterator itr) {
+    detachNode(n, itr);
+    table->at(n).erase(itr);
+}
+
+// Shrinks the table once enough keys have been removed that the load factor is under minLoad
+template<class Key, class Hash>
+void HashTable<Key, Hash>::shrinkIfSparse() {
+
+    if (load_factor() >= minLoad || bucketCount <= minBuckets) {
+        return;
+    }
+
+    // Land halfway to the max load factor, so a few inserts don't immediately grow it back
+    int target = int(HashPrimes::nextPrime(std::max<size_t>(minBuckets, size_t(float(currentSize) / (maxLoad / 2)))));
+    if (target < bucketCount) {
+        rehash(target);
+    }
 }
 
 // Function to return the number of buckets in a table
@@ -254,35 +806,21 @@ size_t HashTable<Key, Hash>::bucket_size(size_t n) const {
     }
 
     // Return the size (amount of items) in that bucket
-    return table->at(n).size();
+    return bucketAt(n).size();
 }
 
 // Function that returns the index of the bucket containing the key, or the bucket that would contain it if it existed.
 template<class Key, class Hash>
 size_t HashTable<Key, Hash>::bucket(const key_type &key) const {
-    // Hash the key for use
-    size_t hash_value = Hash{}(key);
-    hash_value = hash_value % bucketCount;
-
-    std::list<key_type> hashList = table->at(hash_value);
-
-    key_type other_value;
-
-    // Grab the key from each index of the list and check it against the parameter
-    for (int i = 0; i < hashList.size(); i++) {
-
-        // Use the keys from our shallow copies
-        other_value = hashList.front();
-        // Pop the front after we evaluate it to iterate through our local copy
-        hashList.pop_front();
-
-        if (key == other_value) {
-            return hash_value;
-        }
-    }
+    // Either way it's the bucket the key hashes to
+    return hashIndex(key);
+}
 
-    // If we make it past the above expression, then we've found the element
-    return hash_value;
+// Transparent version of bucket, the key only has to be hashable by Hash
+template<class Key, class Hash>
+template<class K, class H, class>
+size_t HashTable<Key, Hash>::bucket(const K &key) const {
+    return hashIndex(key);
 }
 
 // Function to calculate and return the current load factor
@@ -314,24 +852,166 @@ void HashTable<Key, Hash>::max_load_factor(float mlf) {
     }
 }
 
-// Function to rehash the table when necessary
+// Function to return the load factor under which removing keys shrinks the table
 template<class Key, class Hash>
-void HashTable<Key, Hash>::rehash(HashTable::size_type count) {
+float HashTable<Key, Hash>::min_load_factor() const {
+    return minLoad;
+}
 
-    // Temp vector to store the lists with keys, and a list containing each value from the hashTable
-    std::vector<std::list<Key>> copyVector;
-    std::list<Key> masterList;
-    std::list<Key> tmpList;
+// Function to set a new minimum load factor, 0 turns automatic shrinking off. It should stay well
+// under half of the max load factor, or the table would shrink straight back to the same size.
+template<class Key, class Hash>
+void HashTable<Key, Hash>::min_load_factor(float mlf) {
+    minLoad = mlf;
+    shrinkIfSparse();
+}
+
+// Function to return whether make_empty leaves the old keys for later instead of freeing them
+template<class Key, class Hash>
+bool HashTable<Key, Hash>::lazy_clear() const {
+    return lazyClear;
+}
+
+// Function to turn lazy clearing on or off. Lazy clearing makes make_empty constant time, which
+// pays off for a big table that's refilled with a few keys and emptied over and over. Turning it
+// off frees whatever stale keys are still around.
+template<class Key, class Hash>
+void HashTable<Key, Hash>::lazy_clear(bool enabled) {
 
-    // Loop to create the master list containing all of our elements
     for (unsigned int i = 0; i < table->size(); i++) {
-        copyVector.push_back(table->at(i));
-        tmpList = table->at(i);
-        for (unsigned int j = 0; j < tmpList.size(); j++) {
-            masterList.push_front(tmpList.front());
-            tmpList.pop_front();
+        if (isStale(i)) {
+            table->at(i).clear();
         }
     }
+    lazyClear = enabled;
+    resetStamps();
+}
+
+// Function to rehash the table when necessary. The new bucket count is the next prime at or above
+// count, and at least enough to stay under the max load factor.
+// Tables big enough to move their nodes in parallel use the shared pool, which only gets started
+// the first time one needs it.
+template<class Key, class Hash>
+void HashTable<Key, Hash>::rehash(HashTable::size_type count) {
+    rehashOn(count, table->size() >= parallelRehashThreshold ? &WorkStealingPool::shared() : nullptr);
+}
+
+// Same as rehash, with big tables moving their nodes on the given pool instead of the shared one
+template<class Key, class Hash>
+void HashTable<Key, Hash>::rehash(HashTable::size_type count, WorkStealingPool &pool) {
+    rehashOn(count, &pool);
+}
+
+// Does the rehashing, in parallel on pool when there is one and the table is big enough
+template<class Key, class Hash>
+void HashTable<Key, Hash>::rehashOn(HashTable::size_type count, WorkStealingPool *pool) {
+
+    size_t needed = size_t(float(currentSize) / float(maxLoad));
+    int newCount = int(HashPrimes::nextPrime(std::max<size_t>(count, needed)));
+
+    // Move every node over with splice, using the cached hash so no key is hashed or copied
+    auto *newTable = new std::vector<std::list<node>>(newCount);
+    if (pool != nullptr && table->size() >= parallelRehashThreshold && pool->thread_count() > 1) {
+        spliceInParallel(*newTable, *pool);
+    } else {
+        for (unsigned int i = 0; i < table->size(); i++) {
+            std::list<node> &oldList = bucketAt(i);
+            while (!oldList.empty()) {
+                std::list<node> &newList = newTable->at(homeIndex(oldList.front().hashCode, newCount));
+                newList.splice(newList.end(), oldList, oldList.begin());
+            }
+        }
+    }
+
+    releaseTable();
+    table = newTable;
+    bucketCount = newCount;
+    resetStamps();
+
+    // Splice keeps the nodes alive, but they're in different buckets now
+    rebuildTreeBins();
+}
+
+// Moves every node into newTable with one task per range of old buckets. Buckets are picked by
+// scaling the mixed hash (see scaleHash), so a range of old buckets only sends nodes to a range of
+// new buckets, and neighbouring ranges can only meet at the first new bucket of the later one.
+// Each task splices straight into the new buckets it owns and collects the nodes for that first
+// one on the side, so no list is ever touched by two threads. Stale buckets are just freed.
+template<class Key, class Hash>
+void HashTable<Key, Hash>::spliceInParallel(std::vector<std::list<node>> &newTable, WorkStealingPool &pool) {
+
+    size_t oldCount = table->size();
+    size_t newCount = newTable.size();
+    size_t ranges = std::max<size_t>(1, std::min<size_t>(size_t(pool.thread_count()) * 8, oldCount / rangeBuckets));
+
+    std::vector<std::list<node>> sharedLists(ranges);
+    std::vector<size_t> sharedBuckets(ranges);
+    pool.parallel_for(ranges, 1, [&](size_t begin, size_t end) {
+        for (size_t r = begin; r < end; r++) {
+            size_t first = chunkStart(oldCount, r, ranges);
+            size_t last = chunkStart(oldCount, r + 1, ranges);
+            sharedBuckets[r] = scaleHash(homeStart(first, oldCount), newCount);
+
+            for (size_t i = first; i < last; i++) {
+                std::list<node> &oldList = table->at(i);
+                if (isStale(i)) {
+                    oldList.clear();
+                    continue;
+                }
+                while (!oldList.empty()) {
+                    size_t n = homeIndex(oldList.front().hashCode, newCount);
+                    std::list<node> &newList = n == sharedBuckets[r] && r > 0 ? sharedLists[r] : newTable[n];
+                    newList.splice(newList.end(), oldList, oldList.begin());
+                }
+            }
+        }
+    });
+
+    for (size_t r = 1; r < ranges; r++) {
+        std::list<node> &newList = newTable[sharedBuckets[r]];
+        newList.splice(newList.end(), sharedLists[r]);
+    }
+}
+
+// Function to make room for count keys under the current max load factor, so inserting that many
+// never triggers a rehash. It never shrinks the table, and removing keys won't shrink it below this
+// size either until shrink_to_fit.
+template<class Key, class Hash>
+void HashTable<Key, Hash>::reserve(HashTable::size_type count) {
+    growFor(count);
+    minBuckets = int(std::max<size_t>(minBuckets, size_t(std::ceil(float(count) / maxLoad))));
+}
+
+// Grows the table so count keys fit under the max load factor. Range inserts presize with this
+// rather than reserve, so the table can still shrink once their keys are removed again.
+template<class Key, class Hash>
+void HashTable<Key, Hash>::growFor(size_t count) {
+
+    size_t needed = size_t(std::ceil(float(count) / maxLoad));
+    if (needed > size_t(bucketCount)) {
+        rehash(needed);
+    }
+}
+
+// Function to shrink the table to the fewest buckets that hold its keys under the max load factor.
+// Unlike automatic shrinking this also gives back what reserve asked for, and the smaller size
+// becomes the new floor. It never grows the table, and a table that hasn't allocated yet only
+// changes the bucket count it will allocate with.
+template<class Key, class Hash>
+void HashTable<Key, Hash>::shrink_to_fit() {
+
+    int target = int(HashPrimes::nextPrime(std::max<size_t>(1, size_t(std::ceil(float(currentSize) / maxLoad)))));
+    if (target >= bucketCount) {
+        minBuckets = std::min(minBuckets, bucketCount);
+        return;
+    }
+
+    minBuckets = target;
+    if (table == emptyTable()) {
+        bucketCount = target;
+        return;
+    }
+    rehash(size_t(target));
 }
 
 template<class Key, class Hash>
@@ -341,16 +1021,14 @@ void HashTable<Key, Hash>::print_table(std::ostream &os) const {
         std::cout << "<empty>\n";
     }
 
-    std::list<Key> tmpList;
-    // Loop through the array, and print the contents of each cell, if it's active
+    // Loop through the array, and print the contents of each bucket, if it has any
     for (unsigned int i = 0; i < table->size(); i++) {
-        tmpList = table->at(i);
-        if ((!tmpList.empty())) {
+        const std::list<node> &hashList = bucketAt(i);
+        if ((!hashList.empty())) {
             os << "[ " << toascii(i) << " ]\n";
             os << "{ \n";
-            while (!tmpList.empty()) {
-                os << "   " << tmpList.front() << "\n";
-                tmpList.pop_front();
+            for (const node &element : hashList) {
+                os << "   " << element.key << "\n";
             }
             os << "} \n";
 
@@ -358,43 +1036,428 @@ void HashTable<Key, Hash>::print_table(std::ostream &os) const {
     }
 }
 
+// Function to collect every key in the table into a single vector
+template<class Key, class Hash>
+std::vector<Key> HashTable<Key, Hash>::keys() const {
+
+    std::vector<Key> allKeys;
+    allKeys.reserve(currentSize);
 
+    // Walk the lists in place, no need to copy them like print_table does
+    for (unsigned int i = 0; i < table->size(); i++) {
+        for (const node &element : bucketAt(i)) {
+            allKeys.push_back(element.key);
+        }
+    }
+    return allKeys;
+}
+
+// Makes an iterator at the start of bucket n, moved forward to the first key at or after it
 template<class Key, class Hash>
-int HashTable<Key, Hash>::nextPrime(int count) {
+HashTable<Key, Hash>::const_iterator::const_iterator(const HashTable *table, size_t n) : owner(table), bucketIndex(n) {
+    if (bucketIndex < size_t(owner->bucketCount)) {
+        position = owner->bucketAt(bucketIndex).begin();
+        bucketEnd = owner->bucketAt(bucketIndex).end();
+        skipEmptyBuckets();
+    }
+}
 
-    // Handle base case / negative inputs
-    if (count <= 1) {
-        return 2;
+// Moves on to the next bucket that has keys, if the iterator is at the end of its current one
+template<class Key, class Hash>
+void HashTable<Key, Hash>::const_iterator::skipEmptyBuckets() {
+    while (position == bucketEnd) {
+        bucketIndex += 1;
+        if (bucketIndex == size_t(owner->bucketCount)) {
+            return;
+        }
+        const std::list<node> &hashList = owner->bucketAt(bucketIndex);
+        position = hashList.begin();
+        bucketEnd = hashList.end();
     }
+}
 
-    int returnPrime = count;
-    bool foundPrime = false;
+// Function to return an iterator to the first key in the table
+template<class Key, class Hash>
+typename HashTable<Key, Hash>::const_iterator HashTable<Key, Hash>::begin() const {
+    return const_iterator(this, 0);
+}
 
-    while (true) {
-        if (isPrime(returnPrime)) {
-            return returnPrime;
+// Function to return the iterator one past the last key in the table
+template<class Key, class Hash>
+typename HashTable<Key, Hash>::const_iterator HashTable<Key, Hash>::end() const {
+    return const_iterator(this, bucketCount);
+}
+
+// Function to call fn on every key in the table, walking the lists in place
+template<class Key, class Hash>
+template<class Fn>
+void HashTable<Key, Hash>::for_each(Fn fn) const {
+    for (unsigned int i = 0; i < table->size(); i++) {
+        for (const node &element : bucketAt(i)) {
+            fn(element.key);
         }
-        returnPrime += 1;
     }
 }
 
+// Function to call fn on every key with the buckets split into chunks that the pool's threads
+// work through, stealing from each other. fn gets called from several threads at once, in no
+// particular order.
+template<class Key, class Hash>
+template<class Fn>
+void HashTable<Key, Hash>::parallel_for_each(Fn fn, WorkStealingPool &pool) const {
+    forEachChunk(pool, table->size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            for (const node &element : bucketAt(i)) {
+                fn(element.key);
+            }
+        }
+    });
+}
+
+// Function to count the keys pred returns true for, split up like parallel_for_each. Each chunk
+// is counted locally and only added to the total once it's done.
 template<class Key, class Hash>
-bool HashTable<Key, Hash>::isPrime(int count) {
+template<class Pred>
+size_t HashTable<Key, Hash>::parallel_count_if(Pred pred, WorkStealingPool &pool) const {
+
+    std::atomic<size_t> total(0);
+    forEachChunk(pool, table->size(), [&](size_t begin, size_t end) {
+        size_t matches = 0;
+        for (size_t i = begin; i < end; i++) {
+            for (const node &element : bucketAt(i)) {
+                matches += pred(element.key) ? 1 : 0;
+            }
+        }
+        total.fetch_add(matches, std::memory_order_relaxed);
+    });
+    return total.load();
+}
 
-    if (count % 2 == 0 || count <= 1) {
-        return false;
+// Function to walk the table a few buckets at a time, Redis SCAN style. Start with cursor 0, then
+// keep passing back the returned cursor until it comes back as 0. Each call visits at most count
+// buckets and calls fn on every key in them that the scan hasn't reported yet.
+// Redis resumes across a resize by walking power-of-two tables in reverse-binary order. We get the
+// same effect for any bucket count because buckets are picked by scaling the mixed hash (see
+// scaleHash), which keeps them in mixed hash order: the cursor is simply the smallest mixed hash
+// not reported yet, and in any layout those keys are in its bucket or later. Every key that was
+// in the table for the whole scan is reported exactly once, however much it grew or shrank.
+template<class Key, class Hash>
+template<class Fn>
+uint64_t HashTable<Key, Hash>::scan(uint64_t cursor, size_t count, Fn fn) const {
+
+    size_t n = scaleHash(cursor, bucketCount);
+    size_t stop = std::min(size_t(bucketCount), n + std::max<size_t>(count, 1));
+    for (size_t i = n; i < stop; i++) {
+        for (const node &element : bucketAt(i)) {
+            // The first bucket can hold keys below the cursor, which were reported last time
+            if (i != n || mixHash(element.hashCode) >= cursor) {
+                fn(element.key);
+            }
+        }
     }
 
-    // Already checked for divisibility by 2, so we can iterate through odd numbers now
-    for (int i = 3; i < (count / 2); i+=2) {
-        if (count % i == 0) {
-            // If this is true, we've found a factor, meaning the number isn't prime
-            return false;
+    if (stop == size_t(bucketCount)) {
+        return 0;
+    }
+    return homeStart(stop, bucketCount);
+}
+
+// Function to build an immutable, pointer-free copy of the table once it won't change anymore
+template<class Key, class Hash>
+FrozenHashTable<Key, Hash> HashTable<Key, Hash>::freeze() const {
+    return FrozenHashTable<Key, Hash>(keys(), hasher);
+}
+
+// Function to replace the table's contents with the keys in [first, last), using several threads.
+// The buckets are sized for the whole range up front, the keys are partitioned by bucket range
+// so every thread fills its own buckets without locking, and the result holds the same keys in
+// the same chain order as inserting them one at a time.
+template<class Key, class Hash>
+template<class RandomIt>
+void HashTable<Key, Hash>::build(RandomIt first, RandomIt last, unsigned threads) {
+
+    size_t count = size_t(last - first);
+    threads = std::max(1u, threads);
+
+    // Start over with enough buckets for every key
+    int newCount = int(HashPrimes::nextPrime(std::max<size_t>(bucketCount, size_t(float(count) / float(maxLoad)))));
+    releaseTable();
+    table = new std::vector<std::list<node>>(newCount);
+    bucketCount = newCount;
+    resetStamps();
+    treeBins.clear();
+
+    // Hash every key once, and note which thread owns the bucket it lands in
+    std::vector<size_t> hashes(count);
+    std::vector<size_t> owners(count);
+    runOnThreads(threads, [&](unsigned t) {
+        for (size_t i = chunkStart(count, t, threads); i < chunkStart(count, t + 1, threads); i++) {
+            hashes[i] = hasher(first[i]);
+            owners[i] = homeIndex(hashes[i], bucketCount) * threads / bucketCount;
+        }
+    });
+
+    std::vector<size_t> order;
+    std::vector<size_t> starts;
+    partitionIndices(owners, threads, threads, order, starts);
+
+    // Every thread only touches its own range of buckets
+    std::vector<size_t> added(threads, 0);
+    runOnThreads(threads, [&](unsigned t) {
+        for (size_t k = starts[t]; k < starts[t + 1]; k++) {
+            size_t i = order[k];
+            std::list<node> &hashList = table->at(homeIndex(hashes[i], bucketCount));
+            bool duplicate = false;
+            for (const node &element : hashList) {
+                if (element.hashCode == hashes[i] && element.key == first[i]) {
+                    duplicate = true;
+                    break;
+                }
+            }
+            if (!duplicate) {
+                hashList.push_back(node{first[i], hashes[i]});
+                added[t] += 1;
+            }
         }
+    });
+
+    currentSize = 0;
+    for (size_t value : added) {
+        currentSize += int(value);
     }
+    rebuildTreeBins();
+}
 
-    // If we make it through the loop, then the number is prime
-    return true;
+// Returns the hash this table gives a node from another table. A hasher without any state (like
+// std::hash or StringHash) hashes the same way in every table, so the node's cached hash is reused
+// instead of hashing the key again; a seeded hasher has to hash it with our seed.
+template<class Key, class Hash>
+size_t HashTable<Key, Hash>::hashOf(const node &element) const {
+    if constexpr (std::is_empty_v<Hash>) {
+        return element.hashCode;
+    } else {
+        return hasher(element.key);
+    }
+}
+
+// Finds our node for every key of other that we also hold, looking up other's keys in our buckets.
+// The lookups don't change anything, so other's buckets are split into chunks on the pool.
+template<class Key, class Hash>
+std::vector<typename HashTable<Key, Hash>::nodeIterator> HashTable<Key, Hash>::findShared(const HashTable &other, WorkStealingPool &pool) const {
+
+    std::vector<nodeIterator> shared;
+    std::mutex sharedMutex;
+    forEachChunk(pool, other.table->size(), [&](size_t begin, size_t end) {
+        std::vector<nodeIterator> found;
+        for (size_t i = begin; i < end; i++) {
+            for (const node &element : other.bucketAt(i)) {
+                size_t hashCode = hashOf(element);
+                nodeIterator itr = findNode(element.key, hashCode);
+                if (itr != table->at(homeIndex(hashCode, bucketCount)).end()) {
+                    found.push_back(itr);
+                }
+            }
+        }
+        std::lock_guard<std::mutex> lock(sharedMutex);
+        shared.insert(shared.end(), found.begin(), found.end());
+    });
+    return shared;
 }
 
+// Erases every node drop returns true for, with our buckets split into chunks on the pool.
+// Each chunk only erases from its own buckets, and the tree bins are rebuilt once at the end.
+template<class Key, class Hash>
+template<class Drop>
+void HashTable<Key, Hash>::eraseNodes(Drop drop, WorkStealingPool &pool) {
+
+    std::atomic<size_t> erased(0);
+    forEachChunk(pool, table->size(), [&](size_t begin, size_t end) {
+        size_t count = 0;
+        for (size_t i = begin; i < end; i++) {
+            if (isStale(i)) {
+                continue;
+            }
+            std::list<node> &hashList = table->at(i);
+            for (auto itr = hashList.begin(); itr != hashList.end();) {
+                if (drop(*itr)) {
+                    itr = hashList.erase(itr);
+                    count += 1;
+                } else {
+                    ++itr;
+                }
+            }
+        }
+        erased.fetch_add(count, std::memory_order_relaxed);
+    });
+
+    currentSize -= int(erased.load());
+    rebuildTreeBins();
+    shrinkIfSparse();
+}
+
+// Function to add every key of other to the table (set union). The table is grown once for both
+// tables' keys up front, and other's cached hashes are reused when the hasher has no seed. Every
+// key is copied and other is left alone, merge moves the nodes over instead.
+template<class Key, class Hash>
+void HashTable<Key, Hash>::union_with(const HashTable &other) {
+
+    if (this == &other || other.is_empty()) {
+        return;
+    }
+
+    growFor(size_t(currentSize) + other.size());
+    for (unsigned int i = 0; i < other.table->size(); i++) {
+        for (const node &element : other.bucketAt(i)) {
+            insertHashed(element.key, hashOf(element));
+        }
+    }
+}
+
+// Function to move every key of other that we don't already hold into the table, relinking its
+// nodes instead of copying them, so the only allocations are resizing the two bucket arrays. Like
+// std::unordered_set::merge, keys we already hold stay behind in other.
+template<class Key, class Hash>
+void HashTable<Key, Hash>::merge(HashTable &other) {
+
+    if (this == &other || other.is_empty()) {
+        return;
+    }
+
+    growFor(size_t(currentSize) + other.size());
+    allocateTable();
+    for (unsigned int i = 0; i < other.table->size(); i++) {
+        if (other.isStale(i)) {
+            continue;
+        }
+        std::list<node> &source = other.table->at(i);
+        for (auto itr = source.begin(); itr != source.end();) {
+            auto next = std::next(itr);
+            size_t hashCode = hashOf(*itr);
+            size_t n = homeIndex(hashCode, bucketCount);
+            std::list<node> &hashList = bucketAt(n);
+            if (findNode(itr->key, hashCode) == hashList.end()) {
+                itr->hashCode = hashCode;
+                hashList.splice(hashList.end(), source, itr);
+                linkLast(n);
+                other.currentSize -= 1;
+            }
+            itr = next;
+        }
+    }
+
+    // Our tree bins were kept up to date by linkLast, other's still point at the nodes it lost
+    other.rebuildTreeBins();
+    other.shrinkIfSparse();
+}
+
+// Same as merge, for a table that's about to go away anyway
+template<class Key, class Hash>
+void HashTable<Key, Hash>::merge(HashTable &&other) {
+    merge(other);
+}
+
+// Function to keep only the keys that other holds too (set intersection). Whichever table is
+// smaller gets looked up in the other one: when it's us, every bucket drops the keys other doesn't
+// have; when it's other, the nodes of the keys we share are set aside, everything else is cleared
+// and they're relinked, so no node is copied. The lookups run on the pool.
+template<class Key, class Hash>
+void HashTable<Key, Hash>::intersect_with(const HashTable &other, WorkStealingPool &pool) {
+
+    if (this == &other || is_empty()) {
+        return;
+    }
+
+    if (size() <= other.size()) {
+        eraseNodes([&](const node &element) {
+            return !other.containsHashed(element.key, other.hashOf(element));
+        }, pool);
+        return;
+    }
+
+    std::vector<nodeIterator> shared = findShared(other, pool);
+    std::list<node> kept;
+    for (nodeIterator itr : shared) {
+        kept.splice(kept.end(), table->at(homeIndex(itr->hashCode, bucketCount)), itr);
+    }
+    forEachChunk(pool, table->size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            table->at(i).clear();
+        }
+    });
+    resetStamps();
+    while (!kept.empty()) {
+        std::list<node> &hashList = table->at(homeIndex(kept.front().hashCode, bucketCount));
+        hashList.splice(hashList.end(), kept, kept.begin());
+    }
+
+    currentSize = int(shared.size());
+    rebuildTreeBins();
+    shrinkIfSparse();
+}
+
+// Function to remove every key that other holds (set difference). Like intersect_with, the smaller
+// table is looked up in the larger one, with the lookups on the pool.
+template<class Key, class Hash>
+void HashTable<Key, Hash>::difference_with(const HashTable &other, WorkStealingPool &pool) {
+
+    if (is_empty() || other.is_empty()) {
+        return;
+    }
+    if (this == &other) {
+        make_empty();
+        shrinkIfSparse();
+        return;
+    }
+
+    if (size() <= other.size()) {
+        eraseNodes([&](const node &element) {
+            return other.containsHashed(element.key, other.hashOf(element));
+        }, pool);
+        return;
+    }
+
+    // Only the buckets holding shared keys are touched
+    for (nodeIterator itr : findShared(other, pool)) {
+        eraseNode(homeIndex(itr->hashCode, bucketCount), itr);
+    }
+    shrinkIfSparse();
+}
+
+// Function to check whether other holds every key in the table. A bigger table can't be a subset,
+// otherwise our keys are looked up in other on the pool, stopping once one is missing.
+template<class Key, class Hash>
+bool HashTable<Key, Hash>::is_subset_of(const HashTable &other, WorkStealingPool &pool) const {
+
+    if (size() > other.size()) {
+        return false;
+    }
+    if (this == &other || is_empty()) {
+        return true;
+    }
+
+    std::atomic<bool> missing(false);
+    forEachChunk(pool, table->size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end && !missing.load(std::memory_order_relaxed); i++) {
+            for (const node &element : bucketAt(i)) {
+                if (!other.containsHashed(element.key, other.hashOf(element))) {
+                    missing.store(true, std::memory_order_relaxed);
+                    break;
+                }
+            }
+        }
+    });
+    return !missing.load();
+}
+
+// Function to return a copy of the table's hasher
+template<class Key, class Hash>
+typename HashTable<Key, Hash>::hash HashTable<Key, Hash>::hash_function() const {
+    return hasher;
+}
+
+// A hashtable whose hasher gets a random seed, for keys that come from untrusted input. Only string
+// and integral keys are supported (see SeededHash).
+template<class Key>
+using SeededHashTable = HashTable<Key, SeededHash<Key>>;
+
 #endif  // HASHTABLE_SEPARATE_CHAINING_H
\ No newline at end of file
@@ -11,9 +11,16 @@
 **
 ***********************************************/
 
+#include <atomic>
 #include <iostream>
 #include <sstream>
+#include <string>
 #include "hashtable_separate_chaining.h"
+#include "hashtable_hash.h"
+#include "hashtable_perfect.h"
+#include "hashtable_small.h"
+#include "hashtable_bucketized.h"
+#include "hashtable_inline.h"
 
 using std::cout, std::endl;
 
@@ -109,6 +116,431 @@ int main() {
     std::cout << " ==> bucket " << index << std::endl;
     std::cout << "     which has " << table.bucket_size(index) << " elements" << std::endl;
 
+    // Test freezing the table into its read-only form
+    std::cout << "freeze the table" << std::endl;
+    FrozenHashTable<std::string> frozen = table.freeze();
+    std::cout << "frozen size is " << frozen.size() << std::endl;
+    std::cout << "frozen bucket count is " << frozen.bucket_count() << std::endl;
+    std::cout << "frozen contains 'Sailing into Destiny' " << frozen.contains("Sailing into Destiny") << std::endl;
+    std::cout << "frozen contains 'Each must know their Part' " << frozen.contains("Each must know their Part") << std::endl;
+
+    // Test building a minimal perfect hash from the keys, and round tripping it through a stream
+    std::cout << "build a perfect hash from the keys" << std::endl;
+    PerfectHashTable<std::string> perfect(table.keys());
+    std::cout << "perfect size is " << perfect.size() << std::endl;
+    std::cout << "perfect index of 'I will draw the Chart' is " << perfect.index("I will draw the Chart") << std::endl;
+    {
+        std::stringstream ss;
+        perfect.serialize(ss);
+        PerfectHashTable<std::string> loaded = PerfectHashTable<std::string>::deserialize(ss);
+        std::cout << "loaded contains 'I will draw the Chart' " << loaded.contains("I will draw the Chart") << std::endl;
+        std::cout << "loaded contains 'Each must know their Part' " << loaded.contains("Each must know their Part") << std::endl;
+    }
+
+    // Test that repeated keys are only stored once, and that a corrupt stream is rejected
+    {
+        PerfectHashTable<int> repeats(std::vector<int>{1, 2, 3, 3});
+        std::cout << "perfect hash of {1, 2, 3, 3} has size " << repeats.size() << std::endl;
+
+        std::stringstream ss;
+        repeats.serialize(ss);
+        std::string bytes = ss.str();
+        std::string badHeader = bytes;
+        badHeader[8] = 0;
+        std::string noPilots = bytes;
+        noPilots[16] = 0;
+        for (const std::string &corrupt : {badHeader, noPilots, bytes.substr(0, bytes.size() - 1)}) {
+            std::stringstream in(corrupt);
+            try {
+                PerfectHashTable<int>::deserialize(in);
+                std::cout << "corrupt stream was accepted" << std::endl;
+            } catch (const std::runtime_error &error) {
+                std::cout << "corrupt stream rejected: " << error.what() << std::endl;
+            }
+        }
+    }
+
+    // Test transparent lookups, none of these build a std::string
+    {
+        std::cout << "look up string_views in a transparent table" << std::endl;
+        HashTable<std::string, StringHash> transparent;
+        transparent.insert("Closer to the Heart");
+        transparent.insert("Forge their Creativity");
+        std::string_view request = "GET Closer to the Heart";
+        std::cout << "contains view " << transparent.contains(request.substr(4)) << std::endl;
+        std::cout << "contains literal " << transparent.contains("Forge their Creativity") << std::endl;
+        std::cout << "bucket of view is " << transparent.bucket(request.substr(4)) << std::endl;
+        std::cout << "remove view " << transparent.remove(request.substr(4)) << std::endl;
+        std::cout << "size is " << transparent.size() << std::endl;
+    }
+
+    // Test a table with a randomly seeded hasher, copies have to keep the same seed
+    {
+        std::cout << "insert into a seeded table" << std::endl;
+        SeededHashTable<std::string> seeded;
+        seeded.insert("You can be the Captain");
+        seeded.insert("I will draw the Chart");
+        SeededHashTable<std::string> seededCopy(seeded);
+        SeededHashTable<std::string> other;
+        std::cout << "copy contains 'I will draw the Chart' " << seededCopy.contains("I will draw the Chart") << std::endl;
+        std::cout << "copy kept the seed " << (seededCopy.hash_function().seed() == seeded.hash_function().seed()) << std::endl;
+        std::cout << "another table got its own seed " << (other.hash_function().seed() != seeded.hash_function().seed()) << std::endl;
+    }
+
+    // Test the fast long-key hashers, they're transparent too
+    {
+        std::cout << "insert into WyHash and StripeHash tables" << std::endl;
+        std::string longKey(300, 'x');
+        HashTable<std::string, WyHash> wyTable;
+        HashTable<std::string, StripeHash> stripeTable;
+        wyTable.insert(longKey);
+        stripeTable.insert(longKey);
+        std::cout << "contains long key " << wyTable.contains(std::string_view(longKey)) << " " << stripeTable.contains(std::string_view(longKey)) << std::endl;
+    }
+
+    // Test that StripeHash depends on the order of the stripes, not just on which stripes there are
+    {
+        std::cout << "hash every key made of four 64 byte stripes from ABCD" << std::endl;
+        StripeHash stripeHash;
+        std::vector<size_t> hashes;
+        for (int key = 0; key < 256; key++) {
+            std::string value;
+            for (int stripe = 0; stripe < 4; stripe++) {
+                value += std::string(64, char('A' + (key >> (2 * stripe)) % 4));
+            }
+            hashes.push_back(stripeHash(value));
+        }
+        std::sort(hashes.begin(), hashes.end());
+        size_t collisions = hashes.size() - size_t(std::unique(hashes.begin(), hashes.end()) - hashes.begin());
+        std::cout << "collisions " << collisions << std::endl;
+        std::cout << "AB and BA differ " << (stripeHash(std::string(64, 'A') + std::string(64, 'B')) != stripeHash(std::string(64, 'B') + std::string(64, 'A'))) << std::endl;
+    }
+
+    // Test building a table from a whole range at once on several threads
+    {
+        std::cout << "build a table from a range on 4 threads" << std::endl;
+        std::vector<int> values;
+        for (int i = 0; i < 1000; i++) {
+            values.push_back(i % 700);
+        }
+        HashTable<int> built;
+        built.build(values.begin(), values.end(), 4);
+        std::cout << "size is " << built.size() << std::endl;
+        std::cout << "contains 699 " << built.contains(699) << " contains 700 " << built.contains(700) << std::endl;
+    }
+
+    // Test presizing, a table told how many keys are coming shouldn't rehash while they arrive
+    {
+        std::cout << "presize a table for 100 keys" << std::endl;
+        HashTable<int> presized(expected_size, 100);
+        size_t buckets = presized.bucket_count();
+        std::vector<int> values;
+        for (int i = 0; i < 100; i++) {
+            values.push_back(i);
+        }
+        presized.insert(values.begin(), values.end());
+        std::cout << "size is " << presized.size() << ", bucket count unchanged " << (presized.bucket_count() == buckets) << std::endl;
+        presized.reserve(1000);
+        std::cout << "reserve(1000) gives at least 1000 buckets " << (presized.bucket_count() >= 1000) << std::endl;
+    }
+
+    // Test shrinking, removing most of the keys should give most of the buckets back
+    {
+        std::cout << "insert 1000 keys and remove 900 of them" << std::endl;
+        HashTable<int> shrinking;
+        for (int i = 0; i < 1000; i++) {
+            shrinking.insert(i);
+        }
+        size_t peak = shrinking.bucket_count();
+        for (int i = 0; i < 900; i++) {
+            shrinking.remove(i);
+        }
+        std::cout << "size is " << shrinking.size() << ", bucket count shrank " << (shrinking.bucket_count() < peak) << std::endl;
+        std::cout << "contains 950 " << shrinking.contains(950) << std::endl;
+        shrinking.shrink_to_fit();
+        std::cout << "after shrink_to_fit the bucket count is " << shrinking.bucket_count() << std::endl;
+
+        // shrink_to_fit never grows a table, however small it was made
+        HashTable<int> small(3);
+        small.insert(1);
+        small.shrink_to_fit();
+        HashTable<int> unused;
+        unused.shrink_to_fit();
+        std::cout << "shrink_to_fit takes a table of 3 buckets holding 1 key to " << small.bucket_count() << ", contains 1 " << small.contains(1)
+                  << ", and an unused table to " << unused.bucket_count() << std::endl;
+    }
+
+    // Test shrinking after a bulk load, only reserve should stop the table from shrinking
+    {
+        std::cout << "range insert 1000 keys and remove 900 of them" << std::endl;
+        std::vector<int> values;
+        for (int i = 0; i < 1000; i++) {
+            values.push_back(i);
+        }
+        HashTable<int> bulk;
+        bulk.insert(values.begin(), values.end());
+        HashTable<int> reserved;
+        reserved.reserve(1000);
+        reserved.insert(values.begin(), values.end());
+        size_t peak = bulk.bucket_count();
+        for (int i = 0; i < 900; i++) {
+            bulk.remove(i);
+            reserved.remove(i);
+        }
+        std::cout << "bulk loaded bucket count shrank " << (bulk.bucket_count() < peak) << std::endl;
+        std::cout << "reserved bucket count kept " << (reserved.bucket_count() >= peak) << std::endl;
+    }
+
+    // Test clearing a big table and reusing it, make_empty shouldn't leave any old keys behind
+    {
+        std::cout << "fill a table, empty it and reuse it" << std::endl;
+        HashTable<int> scratch;
+        for (int i = 0; i < 500; i++) {
+            scratch.insert(i);
+        }
+        scratch.make_empty();
+        scratch.insert(7);
+        std::cout << "size is " << scratch.size() << ", contains 7 " << scratch.contains(7) << ", contains 8 " << scratch.contains(8) << std::endl;
+        std::cout << "keys left " << scratch.keys().size() << std::endl;
+    }
+
+    // Test lazy clearing, stale keys should stay invisible to lookups, copies and iteration
+    {
+        std::cout << "fill a lazily cleared table, empty it and copy it" << std::endl;
+        HashTable<int> lazy;
+        lazy.lazy_clear(true);
+        for (int i = 0; i < 500; i++) {
+            lazy.insert(i);
+        }
+        lazy.make_empty();
+        lazy.insert(7);
+        const HashTable<int> copy = lazy;
+        size_t iterated = 0;
+        for (int key : copy) {
+            iterated += size_t(key == 7);
+        }
+        std::cout << "lazy " << lazy.lazy_clear() << ", contains 8 " << lazy.contains(8) << ", copy keys " << copy.keys().size() << ", iterated " << iterated << std::endl;
+        lazy.lazy_clear(false);
+        std::cout << "after turning it off, size is " << lazy.size() << ", contains 7 " << lazy.contains(7) << ", contains 8 " << lazy.contains(8) << std::endl;
+    }
+
+    // Test the small table, it keeps a few keys inline and only spills into a real table after that
+    {
+        std::cout << "insert into a small table with 4 inline slots" << std::endl;
+        SmallHashTable<HashTable<int>, 4> small;
+        for (int i = 0; i < 4; i++) {
+            small.insert(i);
+        }
+        std::cout << "size is " << small.size() << ", inline " << small.is_inline() << ", contains 3 " << small.contains(3) << std::endl;
+        small.insert(4);
+        std::cout << "size is " << small.size() << ", inline " << small.is_inline() << ", contains 3 " << small.contains(3) << std::endl;
+    }
+
+    // Test iterating, both with a range-based for loop and with for_each
+    {
+        std::cout << "iterate over a table" << std::endl;
+        HashTable<int> iterated;
+        for (int i = 1; i <= 100; i++) {
+            iterated.insert(i);
+        }
+        int sum = 0;
+        for (int key : iterated) {
+            sum += key;
+        }
+        size_t evens = 0;
+        iterated.for_each([&evens](int key) {
+            evens += key % 2 == 0;
+        });
+        std::cout << "sum is " << sum << ", evens " << evens << ", distance " << std::distance(iterated.begin(), iterated.end()) << std::endl;
+        HashTable<int> empty;
+        std::cout << "empty table begin == end " << (empty.begin() == empty.end()) << std::endl;
+    }
+
+    // Test rehashing a big table on a pool of 4 threads, every node has to land in its new bucket
+    {
+        std::cout << "rehash a table of 200000 keys on 4 threads" << std::endl;
+        HashTable<int> grown;
+        for (int i = 0; i < 200000; i++) {
+            grown.insert(i * 3);
+        }
+        WorkStealingPool pool(4);
+        grown.rehash(grown.bucket_count() * 2, pool);
+        bool all = true;
+        for (int i = 0; i < 200000; i++) {
+            all = all && grown.contains(i * 3);
+        }
+        std::cout << "size is " << grown.size() << ", contains every key " << all << ", contains 1 " << grown.contains(1) << std::endl;
+    }
+
+    // Test the parallel scans, every key should be seen once whichever thread gets its chunk
+    {
+        std::cout << "scan a table on 4 threads" << std::endl;
+        HashTable<int> scanned;
+        for (int i = 1; i <= 100000; i++) {
+            scanned.insert(i);
+        }
+        WorkStealingPool scanPool(4);
+        std::atomic<long long> sum(0);
+        scanned.parallel_for_each([&sum](int key) {
+            sum += key;
+        }, scanPool);
+        size_t multiples = scanned.parallel_count_if([](int key) {
+            return key % 7 == 0;
+        }, scanPool);
+        std::cout << "sum is " << sum << ", multiples of 7 " << multiples << std::endl;
+    }
+
+    // Test the set operations, the intersection and differences both with the smaller table first and second
+    {
+        std::cout << "combine the multiples of 2 and of 3 under 10000" << std::endl;
+        HashTable<int> twos;
+        HashTable<int> threes;
+        for (int i = 0; i < 10000; i++) {
+            if (i % 2 == 0) {
+                twos.insert(i);
+            }
+            if (i % 3 == 0) {
+                threes.insert(i);
+            }
+        }
+        HashTable<int> both = twos;
+        both.union_with(threes);
+        WorkStealingPool setPool(4);
+        HashTable<int> shared = twos;
+        shared.intersect_with(threes, setPool);
+        HashTable<int> sharedToo = threes;
+        sharedToo.intersect_with(twos, setPool);
+        HashTable<int> onlyTwos = twos;
+        onlyTwos.difference_with(threes, setPool);
+        HashTable<int> onlyThrees = threes;
+        onlyThrees.difference_with(twos, setPool);
+        std::cout << "union " << both.size() << ", intersections " << shared.size() << " and " << sharedToo.size()
+                  << ", differences " << onlyTwos.size() << " and " << onlyThrees.size() << std::endl;
+        std::cout << "intersection contains 6 " << shared.contains(6) << " contains 4 " << shared.contains(4)
+                  << ", difference contains 6 " << onlyTwos.contains(6) << " contains 4 " << onlyTwos.contains(4) << std::endl;
+        std::cout << "intersection is a subset of both " << shared.is_subset_of(twos, setPool) << shared.is_subset_of(threes, setPool)
+                  << ", twos of the union " << twos.is_subset_of(both) << ", twos of threes " << twos.is_subset_of(threes) << std::endl;
+    }
+
+    // Test moving nodes between tables, the keys should arrive without being copied
+    {
+        std::cout << "move keys from a hot table to a cold one" << std::endl;
+        HashTable<std::string> hot;
+        HashTable<std::string> cold;
+        for (int i = 0; i < 20; i++) {
+            hot.insert("key" + std::to_string(i));
+        }
+        HashTable<std::string>::node_type handle = hot.extract("key3");
+        const std::string *address = &handle.value();
+        std::cout << "extracted " << handle.value() << ", hot contains it " << hot.contains("key3") << ", hot size " << hot.size() << std::endl;
+        std::cout << "inserted into cold " << cold.insert(std::move(handle)) << ", handle is empty " << handle.empty()
+                  << ", key wasn't copied " << (&*cold.begin() == address) << std::endl;
+        std::cout << "extracting a missing key gives an empty handle " << hot.extract("missing").empty() << std::endl;
+
+        HashTable<std::string>::node_type renamed = hot.extract("key4");
+        renamed.value() = "key40";
+        std::cout << "renamed key4 and put it back " << hot.insert(std::move(renamed)) << ", contains key40 " << hot.contains("key40") << std::endl;
+
+        cold.insert("key5");
+        cold.merge(hot);
+        std::cout << "merged hot into cold, cold size " << cold.size() << ", hot keeps the duplicate key5 " << hot.contains("key5")
+                  << ", hot size " << hot.size() << std::endl;
+    }
+
+    // Test the bucketized table, a bucket only spills into overflow blocks once its own block is full
+    {
+        std::cout << "insert into a bucketized table" << std::endl;
+        BucketizedHashTable<int> blocked;
+        for (int i = 0; i < 1000; i++) {
+            blocked.insert(i);
+        }
+        blocked.remove(500);
+        std::cout << "size is " << blocked.size() << ", contains 499 " << blocked.contains(499) << " contains 500 " << blocked.contains(500)
+                  << ", " << BucketizedHashTable<int>::slotsPerBlock << " ints per block" << std::endl;
+
+        struct SameBucket {
+            size_t operator()(int) const noexcept { return 7; }
+        };
+        BucketizedHashTable<int, SameBucket> crowded(1);
+        for (int i = 0; i < 30; i++) {
+            crowded.insert(i);
+        }
+        std::cout << "30 keys in one bucket use " << crowded.overflow_blocks() << " overflow blocks, finding 0 reads "
+                  << crowded.lookup_blocks(0) << " block and missing reads " << crowded.lookup_blocks(99) << std::endl;
+        for (int i = 0; i < 30; i += 2) {
+            crowded.remove(i);
+        }
+        std::cout << "after removing half, size is " << crowded.size() << ", overflow blocks " << crowded.overflow_blocks()
+                  << ", contains 29 " << crowded.contains(29) << std::endl;
+    }
+
+    // Test the inline-first table, a bucket's first key lives in the bucket array and the rest in nodes
+    {
+        std::cout << "insert strings into an inline-first table" << std::endl;
+        InlineHashTable<std::string> inlined;
+        for (int i = 0; i < 1000; i++) {
+            inlined.insert("key" + std::to_string(i));
+        }
+        inlined.remove("key500");
+        InlineHashTable<std::string> copied(inlined);
+        std::cout << "size is " << copied.size() << ", contains key499 " << copied.contains("key499") << " contains key500 "
+                  << copied.contains("key500") << ", " << copied.overflow_nodes() << " of them in overflow nodes" << std::endl;
+
+        struct SameBucket {
+            size_t operator()(int) const noexcept { return 7; }
+        };
+        InlineHashTable<int, SameBucket> crowded;
+        for (int i = 0; i < 5; i++) {
+            crowded.insert(i);
+        }
+        std::cout << "5 keys in one bucket use " << crowded.overflow_nodes() << " overflow nodes, finding 0 takes "
+                  << crowded.lookup_loads(0) << " loads and missing takes " << crowded.lookup_loads(99) << std::endl;
+        crowded.remove(0);
+        std::cout << "after removing the inline key, size is " << crowded.size() << ", overflow nodes " << crowded.overflow_nodes()
+                  << ", contains 4 " << crowded.contains(4) << std::endl;
+    }
+
+    // Test scanning with a cursor, keys added partway through can make the table grow
+    {
+        std::cout << "scan a table 3 slots at a time while it grows" << std::endl;
+        HashTable<int> scanned;
+        for (int i = 0; i < 50; i++) {
+            scanned.insert(i);
+        }
+        std::vector<bool> seen(50, false);
+        uint64_t cursor = 0;
+        int calls = 0;
+        do {
+            cursor = scanned.scan(cursor, 3, [&seen](int key) {
+                if (key < 50) {
+                    seen[key] = true;
+                }
+            });
+            scanned.insert(1000 + calls);
+            calls += 1;
+        } while (cursor != 0);
+        std::cout << "saw every original key " << (std::count(seen.begin(), seen.end(), true) == 50)
+                  << " in " << calls << " calls, table size " << scanned.size() << std::endl;
+
+        std::cout << "scan it again while it shrinks back down" << std::endl;
+        std::vector<int> reported(50, 0);
+        cursor = 0;
+        calls = 0;
+        do {
+            cursor = scanned.scan(cursor, 3, [&reported](int key) {
+                if (key < 50) {
+                    reported[key] += 1;
+                }
+            });
+            for (int i = 0; i < 5; i++) {
+                scanned.remove(1000 + 5 * calls + i);
+            }
+            calls += 1;
+        } while (cursor != 0);
+        std::cout << "saw every original key exactly once " << (std::count(reported.begin(), reported.end(), 1) == 50)
+                  << ", table size " << scanned.size() << std::endl;
+    }
+
     std::cout << "make the table empty" << std::endl;
     table.make_empty();
 
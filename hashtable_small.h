@@ -0,0 +1,256 @@
+/*****************************************
+** File:    hashtable_small.h
+** Project: CSCE 221 Lab 6 Spring 2022
+** Author:  Joshua Hillis
+** Date:    04/12/2022
+** Section: 512
+** E-mail:  joshuahillis292002@tamu.edu
+**
+** This is the header file for the small hashtable. Most sets we build only ever hold a handful
+** of keys, so this keeps up to N of them inline in the object itself and finds them with a
+** plain linear scan, with no heap allocation and no hashing. Once an (N + 1)th key arrives it
+** spills everything into a full hashtable, either one, given as the Table parameter.
+**
+***********************************************/
+
+#ifndef HASHTABLE_SMALL_H
+#define HASHTABLE_SMALL_H
+
+#include <array>
+#include <memory>
+#include <type_traits>
+#include <vector>
+#include "hashtable_hash.h"
+
+template<class Table, size_t N = 8>
+class SmallHashTable {
+public:
+    using key_type = typename Table::key_type;
+    using value_type = typename Table::value_type;
+    using hash = typename Table::hash;
+    using size_type = size_t;
+
+    static constexpr size_t inlineCapacity = N;
+
+private:
+    // The first inlineCount slots hold the keys while the table is small
+    std::array<key_type, N> inlineKeys{};
+    size_t inlineCount;
+    // Every key lives here instead once we've spilled, and inlineCount stays 0
+    std::unique_ptr<Table> spilled;
+
+    size_t findInline(const key_type &key) const;
+
+public:
+    SmallHashTable();
+
+    SmallHashTable(const SmallHashTable &other);
+
+    SmallHashTable &operator=(const SmallHashTable &other);
+
+    SmallHashTable(SmallHashTable &&other) noexcept = default;
+
+    SmallHashTable &operator=(SmallHashTable &&other) noexcept = default;
+
+    bool is_empty() const;
+
+    size_t size() const;
+
+    bool is_inline() const;
+
+    void make_empty();
+
+    bool insert(const value_type &value);
+
+    size_t remove(const key_type &key);
+
+    bool contains(const key_type &key) const;
+
+    std::vector<key_type> keys() const;
+};
+
+//-------------------------------------------------------
+// Name: Default Constructor
+// Initializes an empty small hashtable, nothing is allocated until it spills
+//---------------------------------------------------------
+template<class Table, size_t N>
+SmallHashTable<Table, N>::SmallHashTable() {
+    inlineCount = 0;
+}
+
+//-------------------------------------------------------
+// Name: Copy Constructor
+// Copies the inline keys, or the spilled table if there is one
+//---------------------------------------------------------
+template<class Table, size_t N>
+SmallHashTable<Table, N>::SmallHashTable(const SmallHashTable &other) {
+    inlineKeys = other.inlineKeys;
+    inlineCount = other.inlineCount;
+    if (other.spilled) {
+        spilled = std::make_unique<Table>(*other.spilled);
+    }
+}
+
+//-------------------------------------------------------
+// Name: Equals operator
+// Allows us to set small hashtables equal to one another and copy them that way
+//---------------------------------------------------------
+template<class Table, size_t N>
+SmallHashTable<Table, N> &SmallHashTable<Table, N>::operator=(const SmallHashTable &other) {
+
+    // Check for self assignment
+    if (this == &other) {
+        return *this;
+    }
+
+    inlineKeys = other.inlineKeys;
+    inlineCount = other.inlineCount;
+    if (other.spilled) {
+        spilled = std::make_unique<Table>(*other.spilled);
+    } else {
+        spilled.reset();
+    }
+    return *this;
+}
+
+//-------------------------------------------------------
+// Name: is_empty
+// Returns true or false depending on whether the table is empty or not
+//---------------------------------------------------------
+template<class Table, size_t N>
+bool SmallHashTable<Table, N>::is_empty() const {
+    return size() == 0;
+}
+
+//-------------------------------------------------------
+// Name: size
+// Returns the number of keys in the table, wherever they're stored
+//---------------------------------------------------------
+template<class Table, size_t N>
+size_t SmallHashTable<Table, N>::size() const {
+    if (spilled) {
+        return spilled->size();
+    }
+    return inlineCount;
+}
+
+//-------------------------------------------------------
+// Name: is_inline
+// Returns true while the keys still live inline, false once the table has spilled
+//---------------------------------------------------------
+template<class Table, size_t N>
+bool SmallHashTable<Table, N>::is_inline() const {
+    return !spilled;
+}
+
+//-------------------------------------------------------
+// Name: make_empty
+// Removes every key. A spilled table is kept (and emptied) so reusing it doesn't reallocate.
+//---------------------------------------------------------
+template<class Table, size_t N>
+void SmallHashTable<Table, N>::make_empty() {
+    if (spilled) {
+        spilled->make_empty();
+    }
+    inlineCount = 0;
+}
+
+//-------------------------------------------------------
+// Name: insert
+// Adds the key if it isn't there yet, spilling into a full hashtable when the inline slots run out
+//---------------------------------------------------------
+template<class Table, size_t N>
+bool SmallHashTable<Table, N>::insert(const value_type &value) {
+
+    if (spilled) {
+        return spilled->insert(value);
+    }
+    if (findInline(value) != inlineCount) {
+        return false;
+    }
+    if (inlineCount < N) {
+        inlineKeys[inlineCount] = value;
+        inlineCount += 1;
+        return true;
+    }
+
+    // Out of room, move everything into a table with space to grow
+    spilled = std::make_unique<Table>(expected_size, 2 * N);
+    for (size_t i = 0; i < inlineCount; i++) {
+        spilled->insert(inlineKeys[i]);
+    }
+    inlineCount = 0;
+    return spilled->insert(value);
+}
+
+//-------------------------------------------------------
+// Name: remove
+// Removes the key if it's there. Inline keys are unordered, so the last one fills the gap.
+//---------------------------------------------------------
+template<class Table, size_t N>
+size_t SmallHashTable<Table, N>::remove(const key_type &key) {
+
+    if (spilled) {
+        return spilled->remove(key);
+    }
+
+    size_t index = findInline(key);
+    if (index == inlineCount) {
+        return 0;
+    }
+    inlineKeys[index] = inlineKeys[inlineCount - 1];
+    inlineCount -= 1;
+    return 1;
+}
+
+//-------------------------------------------------------
+// Name: contains
+// Returns true or false depending on whether the key is in the table
+//---------------------------------------------------------
+template<class Table, size_t N>
+bool SmallHashTable<Table, N>::contains(const key_type &key) const {
+    if (spilled) {
+        return spilled->contains(key);
+    }
+    return findInline(key) != inlineCount;
+}
+
+//-------------------------------------------------------
+// Name: keys
+// Collects every key into a single vector
+//---------------------------------------------------------
+template<class Table, size_t N>
+std::vector<typename SmallHashTable<Table, N>::key_type> SmallHashTable<Table, N>::keys() const {
+    if (spilled) {
+        return spilled->keys();
+    }
+    return std::vector<key_type>(inlineKeys.begin(), inlineKeys.begin() + inlineCount);
+}
+
+//-------------------------------------------------------
+// Name: findInline
+// Linear scan of the inline slots, returns the key's slot or inlineCount if it isn't there.
+// Arithmetic keys compare all N slots with no early exit, which the compiler turns into a few
+// vector compares; other keys stop at the first match since comparing them isn't free.
+//---------------------------------------------------------
+template<class Table, size_t N>
+size_t SmallHashTable<Table, N>::findInline(const key_type &key) const {
+
+    if constexpr (std::is_arithmetic_v<key_type>) {
+        size_t found = inlineCount;
+        for (size_t i = 0; i < N; i++) {
+            bool hit = inlineKeys[i] == key && i < inlineCount;
+            found = hit ? i : found;
+        }
+        return found;
+    } else {
+        for (size_t i = 0; i < inlineCount; i++) {
+            if (inlineKeys[i] == key) {
+                return i;
+            }
+        }
+        return inlineCount;
+    }
+}
+
+#endif  // HASHTABLE_SMALL_H
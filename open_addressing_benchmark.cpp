@@ -0,0 +1,515 @@
+/*****************************************
+** File:    open_addressing_benchmark.cpp
+** Project: CSCE 221 Lab 6 Spring 2022
+** Author:  Joshua Hillis
+** Date:    04/12/2022
+** Section: 512
+** E-mail:  joshuahillis292002@tamu.edu
+**
+** This file times the open addressing hashtable on workloads we care about. Each workload is
+** a function below, and the key count can be given on the command line.
+**
+***********************************************/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "hashtable_open_addressing.h"
+#include "hashtable_small.h"
+#include "hashtable_ordered.h"
+
+using Clock = std::chrono::steady_clock;
+
+double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// The inverse of mixHash. Each xorshift by 33 undoes itself, and each multiply is undone by the
+// multiplier's inverse mod 2^64, found with Newton's iteration (each step doubles the correct bits)
+uint64_t unmixHash(uint64_t mixed) {
+    auto inverse = [](uint64_t value) {
+        uint64_t result = value;
+        for (int i = 0; i < 5; i++) {
+            result *= 2 - value * result;
+        }
+        return result;
+    };
+    mixed ^= mixed >> 33;
+    mixed *= inverse(0xc4ceb9fe1a85ec53ULL);
+    mixed ^= mixed >> 33;
+    mixed *= inverse(0xff51afd7ed558ccdULL);
+    mixed ^= mixed >> 33;
+    return mixed;
+}
+
+// std::hash<long long> is the identity and the table's mixHash has no key, so an attacker can run
+// mixHash backwards and pick keys whose mixed hashes are 0, 1, 2, ... Those all scale to cell 0
+// whatever the table size, and every insert has to walk past all the earlier keys. SeededHash
+// hashes each key with a secret first, so the same keys spread out.
+template<class Hash>
+void adversarialWorkload(const std::string &name, size_t count) {
+
+    std::vector<long long> keys(count);
+    for (size_t i = 0; i < count; i++) {
+        keys[i] = (long long) unmixHash(i);
+    }
+
+    HashTable<long long, Hash> table;
+    Clock::time_point start = Clock::now();
+    for (long long key : keys) {
+        table.insert(key);
+    }
+    double insertTime = secondsSince(start);
+
+    size_t found = 0;
+    start = Clock::now();
+    for (long long key : keys) {
+        found += table.contains(key);
+    }
+    double lookupTime = secondsSince(start);
+
+    std::cout << name << " under attack (" << count << " keys): insert "
+              << double(count) / insertTime / 1e6 << " Mops/s, contains "
+              << double(count) / lookupTime / 1e6 << " Mops/s, " << found << " hits" << std::endl;
+}
+
+// The scalar insert / contains loops against insert_many / contains_many, both on presized tables
+template<class Key>
+void batchWorkload(const std::string &name, size_t count) {
+    std::mt19937_64 rng(221);
+    std::vector<Key> keys(count);
+    for (Key &key : keys) {
+        key = Key(rng());
+    }
+    size_t cells = 2 * count + 1;
+
+    HashTable<Key> looped(cells);
+    Clock::time_point start = Clock::now();
+    for (const Key &key : keys) {
+        looped.insert(key);
+    }
+    double loopInsert = secondsSince(start);
+
+    HashTable<Key> batched(cells);
+    start = Clock::now();
+    batched.insert_many(keys.data(), keys.size());
+    double batchInsert = secondsSince(start);
+
+    size_t found = 0;
+    start = Clock::now();
+    for (const Key &key : keys) {
+        found += looped.contains(key);
+    }
+    double loopContains = secondsSince(start);
+
+    std::unique_ptr<bool[]> results(new bool[count]);
+    start = Clock::now();
+    batched.contains_many(keys.data(), keys.size(), results.get());
+    double batchContains = secondsSince(start);
+    found += std::count(results.get(), results.get() + count, true);
+
+    std::cout << name << " (" << count << " keys): insert loop "
+              << loopInsert * 1e9 / double(count) << " ns/op, insert_many " << batchInsert * 1e9 / double(count)
+              << " ns/op, contains loop " << loopContains * 1e9 / double(count) << " ns/op, contains_many "
+              << batchContains * 1e9 / double(count) << " ns/op, " << found << " hits" << std::endl;
+}
+
+// The home cell kernels on their own over a whole array, scalar against the runtime dispatch
+// (the AVX2 kernel where it applies, so the two columns match on CPUs without it)
+template<class Key, class Hash>
+void homeCellsWorkload(const std::string &name, size_t count) {
+    std::mt19937_64 rng(221);
+    std::vector<Key> keys(count);
+    for (Key &key : keys) {
+        key = Key(rng());
+    }
+    std::vector<size_t> homes(count);
+    size_t cells = 2 * count + 1;
+    Hash hasher;
+    const int rounds = 20;
+
+    size_t checksum = 0;
+    Clock::time_point start = Clock::now();
+    for (int round = 0; round < rounds; round++) {
+        homeCellsScalar(hasher, keys.data(), count, cells, homes.data());
+        checksum += homes[size_t(round) % count];
+    }
+    double scalar = secondsSince(start);
+
+    start = Clock::now();
+    for (int round = 0; round < rounds; round++) {
+        homeCells(hasher, keys.data(), count, cells, homes.data());
+        checksum -= homes[size_t(round) % count];
+    }
+    double dispatched = secondsSince(start);
+
+    std::cout << name << " home cells (" << count << " keys" << (cpuHasAvx2() && vectorHashKind<Key, Hash>() != 0 ? ", avx2" : ", scalar")
+              << "): scalar " << scalar * 1e9 / double(count * rounds) << " ns/key, dispatched "
+              << dispatched * 1e9 / double(count * rounds) << " ns/key, checksum " << checksum << std::endl;
+}
+
+// Inserting a range of keys into a default table against one presized with reserve
+void reserveWorkload(size_t count) {
+    std::mt19937_64 rng(221);
+    std::vector<int> keys(count);
+    for (int &key : keys) {
+        key = int(rng() >> 33);
+    }
+
+    HashTable<int> growing;
+    Clock::time_point start = Clock::now();
+    for (int key : keys) {
+        growing.insert(key);
+    }
+    double growingTime = secondsSince(start);
+
+    HashTable<int> reserved;
+    start = Clock::now();
+    reserved.reserve(count);
+    for (int key : keys) {
+        reserved.insert(key);
+    }
+    double reservedTime = secondsSince(start);
+
+    HashTable<int> ranged;
+    start = Clock::now();
+    ranged.insert(keys.begin(), keys.end());
+    double rangeTime = secondsSince(start);
+
+    std::cout << "insert " << count << " keys: growing " << growingTime * 1e9 / double(count) << " ns/key, reserve "
+              << reservedTime * 1e9 / double(count) << " ns/key, range insert " << rangeTime * 1e9 / double(count)
+              << " ns/key" << std::endl;
+}
+
+// Growing a full table, which rehashes on the shared pool once it has parallelRehashThreshold cells
+void rehashWorkload(size_t count) {
+    HashTable<int> table(expected_size, count);
+    for (size_t i = 0; i < count; i++) {
+        table.insert(int(i * 7));
+    }
+
+    size_t before = table.table_size();
+    Clock::time_point start = Clock::now();
+    table.reserve(count * 2);
+    double time = secondsSince(start);
+
+    std::cout << "rehash " << count << " keys from " << before << " to " << table.table_size() << " cells on "
+              << WorkStealingPool::shared().thread_count() << " pool threads: " << time * 1e3 << " ms ("
+              << time * 1e9 / double(count) << " ns/key)" << std::endl;
+}
+
+// Bulk expiry: remove 90% of the keys, then see how big the table is and how long a scan takes
+void expiryWorkload(size_t count) {
+    HashTable<int> table;
+    for (size_t i = 0; i < count; i++) {
+        table.insert(int(i));
+    }
+    size_t peak = table.table_size();
+
+    Clock::time_point start = Clock::now();
+    for (size_t i = 0; i < count / 10 * 9; i++) {
+        table.remove(int(i));
+    }
+    double removeTime = secondsSince(start);
+    size_t afterRemove = table.table_size();
+
+    table.shrink_to_fit();
+    start = Clock::now();
+    size_t scanned = table.keys().size();
+    double scanTime = secondsSince(start);
+
+    std::cout << "expire 90% of " << count << " keys: remove " << removeTime * 1e9 / double(count / 10 * 9)
+              << " ns/op, size " << peak << " -> " << afterRemove << " -> " << table.table_size()
+              << " after shrink_to_fit, scan of " << scanned << " keys " << scanTime * 1e3 << " ms" << std::endl;
+}
+
+// A reused per-request scratch table: a big table gets a handful of keys and is emptied each time.
+// An eager make_empty walks the whole table, so it gets far fewer requests.
+void scratchWorkload(size_t count, bool lazy) {
+    HashTable<int> scratch(expected_size, count);
+    scratch.lazy_clear(lazy);
+    size_t requests = lazy ? 1000000 : 1000;
+
+    Clock::time_point start = Clock::now();
+    for (size_t request = 0; request < requests; request++) {
+        for (int i = 0; i < 8; i++) {
+            scratch.insert(int(request) * 8 + i);
+        }
+        scratch.make_empty();
+    }
+    double time = secondsSince(start);
+
+    std::cout << "scratch table of " << count << " slots, 8 inserts + " << (lazy ? "lazy" : "eager") << " make_empty: "
+              << time * 1e9 / double(requests) << " ns/request" << std::endl;
+}
+
+// Millions of tiny sets: build one with a few keys, look a few keys up, throw it away
+template<class Table>
+void tinySetWorkload(const std::string &name, size_t count) {
+    size_t found = 0;
+    Clock::time_point start = Clock::now();
+    for (size_t set = 0; set < count; set++) {
+        Table table;
+        int keys = int(set % 12) + 1;
+        for (int i = 0; i < keys; i++) {
+            table.insert(int(set) + i * 31);
+        }
+        for (int i = 0; i < 16; i++) {
+            found += table.contains(int(set) + i * 31);
+        }
+    }
+    double time = secondsSince(start);
+    std::cout << name << " tiny sets (" << count << "): " << time * 1e9 / double(count) << " ns/set, "
+              << found << " hits" << std::endl;
+}
+
+// The ordered table against the open addressing table at a few sizes: memory for the index and
+// keys (an open addressing cell is laid out like a pair of its state and key), repeated full
+// scans, and lookups that hit half the time
+template<class Key, class MakeKey>
+void orderedWorkload(const std::string &name, size_t count, MakeKey makeKey) {
+    for (size_t keys : {size_t(100), size_t(10000), count}) {
+        HashTable<Key> table;
+        OrderedHashTable<Key> ordered;
+        for (size_t i = 0; i < keys; i++) {
+            table.insert(makeKey(i));
+            ordered.insert(makeKey(i));
+        }
+        size_t tableBytes = table.table_size() * sizeof(std::pair<unsigned int, Key>);
+
+        // Scan and look up about count keys' worth whatever the size, so small tables get timed too
+        size_t rounds = std::max<size_t>(1, count / keys);
+        size_t tableMatches = 0;
+        Clock::time_point start = Clock::now();
+        for (size_t round = 0; round < rounds; round++) {
+            Key target = makeKey(round);
+            for (const Key &key : table) {
+                tableMatches += key == target;
+            }
+        }
+        double tableScan = secondsSince(start);
+        size_t orderedMatches = 0;
+        start = Clock::now();
+        for (size_t round = 0; round < rounds; round++) {
+            Key target = makeKey(round);
+            for (const Key &key : ordered) {
+                orderedMatches += key == target;
+            }
+        }
+        double orderedScan = secondsSince(start);
+
+        start = Clock::now();
+        for (size_t round = 0; round < rounds; round++) {
+            for (size_t i = 0; i < keys; i++) {
+                tableMatches += table.contains(makeKey(i * 2));
+            }
+        }
+        double tableLookups = secondsSince(start);
+        start = Clock::now();
+        for (size_t round = 0; round < rounds; round++) {
+            for (size_t i = 0; i < keys; i++) {
+                orderedMatches += ordered.contains(makeKey(i * 2));
+            }
+        }
+        double orderedLookups = secondsSince(start);
+
+        double scanned = double(rounds * keys);
+        std::cout << name << " " << keys << " keys: HashTable " << double(tableBytes) / double(keys) << " bytes/key, scan "
+                  << tableScan * 1e9 / scanned << " ns/key, contains " << tableLookups * 1e9 / scanned << " ns/op; OrderedHashTable "
+                  << double(ordered.memory_usage()) / double(keys) << " bytes/key (" << ordered.index_width() << " byte slots), scan "
+                  << orderedScan * 1e9 / scanned << " ns/key, contains " << orderedLookups * 1e9 / scanned
+                  << " ns/op (counts agree " << (tableMatches == orderedMatches) << ")" << std::endl;
+    }
+}
+
+// Full scans: copying the keys out against iterating and for_each
+void scanWorkload(size_t count) {
+    HashTable<int> table(expected_size, count);
+    for (size_t i = 0; i < count; i++) {
+        table.insert(int(i * 7));
+    }
+
+    Clock::time_point start = Clock::now();
+    long long keysSum = 0;
+    for (int key : table.keys()) {
+        keysSum += key;
+    }
+    double keysTime = secondsSince(start);
+
+    start = Clock::now();
+    long long iteratorSum = 0;
+    for (int key : table) {
+        iteratorSum += key;
+    }
+    double iteratorTime = secondsSince(start);
+
+    start = Clock::now();
+    long long forEachSum = 0;
+    table.for_each([&forEachSum](int key) {
+        forEachSum += key;
+    });
+    double forEachTime = secondsSince(start);
+
+    std::cout << "scan " << count << " keys: keys() " << keysTime * 1e3 << " ms, iterator " << iteratorTime * 1e3
+              << " ms, for_each " << forEachTime * 1e3 << " ms (sums agree "
+              << (keysSum == iteratorSum && iteratorSum == forEachSum) << ")" << std::endl;
+}
+
+// parallel_for_each and parallel_count_if on pools of 1 to N threads against the single threaded for_each
+void parallelScanWorkload(size_t count) {
+    HashTable<int> table(expected_size, count);
+    for (size_t i = 0; i < count; i++) {
+        table.insert(int(i * 7));
+    }
+
+    Clock::time_point start = Clock::now();
+    size_t serialCount = 0;
+    table.for_each([&serialCount](int key) {
+        serialCount += key % 3 == 0;
+    });
+    std::cout << "for_each count (" << count << "): " << secondsSince(start) * 1e3 << " ms" << std::endl;
+
+    for (unsigned threads = 1; threads <= defaultThreadCount(); threads *= 2) {
+        WorkStealingPool pool(threads);
+        start = Clock::now();
+        std::atomic<long long> sum(0);
+        table.parallel_for_each([&sum](int key) {
+            if (key % 3 == 0) {
+                sum.fetch_add(1, std::memory_order_relaxed);
+            }
+        }, pool);
+        double forEachTime = secondsSince(start);
+
+        start = Clock::now();
+        size_t matches = table.parallel_count_if([](int key) {
+            return key % 3 == 0;
+        }, pool);
+        double countTime = secondsSince(start);
+
+        std::cout << "parallel scan on " << threads << " threads: parallel_for_each " << forEachTime * 1e3
+                  << " ms, parallel_count_if " << countTime * 1e3 << " ms (counts agree "
+                  << (size_t(sum) == serialCount && matches == serialCount) << ")" << std::endl;
+    }
+}
+
+// The set operations against the loops they replace, which walk one table calling contains and
+// insert on another. The small table has a quarter as many keys, so intersect_with and
+// difference_with on the big table get to look up the small table's keys instead of their own.
+void setAlgebraWorkload(size_t count) {
+    HashTable<int> big;
+    HashTable<int> small;
+    for (size_t i = 0; i < count; i++) {
+        big.insert(int(i * 2));
+    }
+    for (size_t i = 0; i < count / 4; i++) {
+        small.insert(int(i * 3));
+    }
+
+    Clock::time_point start = Clock::now();
+    HashTable<int> loopUnion = big;
+    for (int key : small) {
+        loopUnion.insert(key);
+    }
+    double loopUnionTime = secondsSince(start);
+    HashTable<int> loopIntersection;
+    HashTable<int> loopDifference;
+    start = Clock::now();
+    for (int key : big) {
+        if (small.contains(key)) {
+            loopIntersection.insert(key);
+        }
+    }
+    double loopIntersectionTime = secondsSince(start);
+    start = Clock::now();
+    for (int key : big) {
+        if (!small.contains(key)) {
+            loopDifference.insert(key);
+        }
+    }
+    double loopDifferenceTime = secondsSince(start);
+    std::cout << "set operations with loops (" << count << " and " << count / 4 << " keys): union " << loopUnionTime * 1e3
+              << " ms, intersection " << loopIntersectionTime * 1e3 << " ms, difference " << loopDifferenceTime * 1e3 << " ms" << std::endl;
+
+    start = Clock::now();
+    HashTable<int> merged = big;
+    merged.union_with(small);
+    double mergeTime = secondsSince(start);
+    std::cout << "union_with: " << mergeTime * 1e3 << " ms (sizes agree " << (merged.size() == loopUnion.size()) << ")" << std::endl;
+
+    for (unsigned threads = 1; threads <= defaultThreadCount(); threads *= 2) {
+        WorkStealingPool pool(threads);
+        HashTable<int> intersection = big;
+        start = Clock::now();
+        intersection.intersect_with(small, pool);
+        double intersectTime = secondsSince(start);
+
+        HashTable<int> difference = big;
+        start = Clock::now();
+        difference.difference_with(small, pool);
+        double differenceTime = secondsSince(start);
+
+        start = Clock::now();
+        bool subset = intersection.is_subset_of(small, pool);
+        double subsetTime = secondsSince(start);
+
+        std::cout << "on " << threads << " threads: intersect_with " << intersectTime * 1e3 << " ms, difference_with "
+                  << differenceTime * 1e3 << " ms, is_subset_of " << subsetTime * 1e3 << " ms (sizes agree "
+                  << (intersection.size() == loopIntersection.size() && difference.size() == loopDifference.size() && subset) << ")" << std::endl;
+    }
+}
+
+// Building from a range on 1 to N threads against inserting the keys one at a time
+void buildWorkload(size_t count) {
+    std::mt19937_64 rng(221);
+    std::vector<int> keys(count);
+    for (int &key : keys) {
+        key = int(rng() >> 33);
+    }
+
+    HashTable<int> looped;
+    Clock::time_point start = Clock::now();
+    for (int key : keys) {
+        looped.insert(key);
+    }
+    std::cout << "sequential insert (" << count << "): " << secondsSince(start) * 1e9 / double(count) << " ns/key" << std::endl;
+
+    for (unsigned threads = 1; threads <= defaultThreadCount(); threads *= 2) {
+        HashTable<int> built;
+        start = Clock::now();
+        built.build(keys.begin(), keys.end(), threads);
+        std::cout << "build on " << threads << " threads: " << secondsSince(start) * 1e9 / double(count)
+                  << " ns/key (" << built.size() << " keys)" << std::endl;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    size_t count = argc > 1 ? std::stoull(argv[1]) : 1000000;
+
+    adversarialWorkload<std::hash<long long>>("std::hash", std::min<size_t>(count, 20000));
+    adversarialWorkload<SeededHash<long long>>("SeededHash", std::min<size_t>(count, 20000));
+    batchWorkload<uint32_t>("uint32_t", count);
+    batchWorkload<uint64_t>("uint64_t", count);
+    homeCellsWorkload<uint32_t, std::hash<uint32_t>>("uint32_t std::hash", count);
+    homeCellsWorkload<uint64_t, std::hash<uint64_t>>("uint64_t std::hash", count);
+    homeCellsWorkload<int, SeededHash<int>>("int SeededHash", count);
+    buildWorkload(count);
+    reserveWorkload(count);
+    rehashWorkload(count);
+    expiryWorkload(count);
+    scratchWorkload(count, false);
+    scratchWorkload(count, true);
+    tinySetWorkload<HashTable<int>>("HashTable", count);
+    tinySetWorkload<SmallHashTable<HashTable<int>, 16>>("SmallHashTable", count);
+    orderedWorkload<int>("int", count, [](size_t i) { return int(i * 7); });
+    orderedWorkload<std::string>("string", std::min<size_t>(count, 200000), [](size_t i) { return "key" + std::to_string(i * 7); });
+    scanWorkload(count);
+    parallelScanWorkload(count);
+    setAlgebraWorkload(count);
+    return 0;
+}
@@ -0,0 +1,78 @@
+/*****************************************
+** File:    perfect_hash_benchmark.cpp
+** Project: CSCE 221 Lab 6 Spring 2022
+** Author:  Joshua Hillis
+** Date:    04/12/2022
+** Section: 512
+** E-mail:  joshuahillis292002@tamu.edu
+**
+** This file times building and querying the minimal perfect hashtable. Key counts are taken
+** from the command line, e.g. "perfect_hash_benchmark 1000000 10000000 100000000".
+**
+***********************************************/
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "hashtable_perfect.h"
+
+using Clock = std::chrono::steady_clock;
+
+double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+int main(int argc, char *argv[]) {
+    std::vector<size_t> counts;
+    for (int i = 1; i < argc; i++) {
+        counts.push_back(std::stoull(argv[i]));
+    }
+    if (counts.empty()) {
+        counts = {1000000, 10000000};
+    }
+
+    std::mt19937_64 rng(221);
+    for (size_t count : counts) {
+        // Random 64 bit keys, duplicates are astronomically unlikely
+        std::vector<uint64_t> keys(count);
+        for (uint64_t &key : keys) {
+            key = rng();
+        }
+
+        Clock::time_point start = Clock::now();
+        PerfectHashTable<uint64_t> perfect(keys.begin(), keys.end());
+        double buildTime = secondsSince(start);
+
+        // Half hits, half misses, with the misses drawn up front so the generator isn't timed
+        std::vector<uint64_t> queries(count);
+        for (size_t i = 0; i < count; i++) {
+            queries[i] = i % 2 == 0 ? keys[i] : rng();
+        }
+        size_t found = 0;
+        start = Clock::now();
+        for (uint64_t query : queries) {
+            found += perfect.contains(query);
+        }
+        double lookupTime = secondsSince(start);
+
+        std::stringstream ss;
+        start = Clock::now();
+        perfect.serialize(ss);
+        PerfectHashTable<uint64_t> loaded = PerfectHashTable<uint64_t>::deserialize(ss);
+        double loadTime = secondsSince(start);
+
+        std::cout << count << " keys: build " << buildTime << " s ("
+                  << buildTime * 1e9 / double(count) << " ns/key), lookup "
+                  << lookupTime * 1e9 / double(count) << " ns/op, "
+                  << found << " hits, serialize + load " << loadTime << " s, "
+                  << ss.str().size() << " bytes" << std::endl;
+        if (loaded.size() != perfect.size()) {
+            std::cout << "  loaded table has the wrong size!" << std::endl;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,791 @@
+/*****************************************
+** File:    separate_chaining_benchmark.cpp
+** Project: CSCE 221 Lab 6 Spring 2022
+** Author:  Joshua Hillis
+** Date:    04/12/2022
+** Section: 512
+** E-mail:  joshuahillis292002@tamu.edu
+**
+** This file times the separate chaining hashtable on workloads we care about. Each workload is
+** a function below, and the key count can be given on the command line.
+**
+***********************************************/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "hashtable_separate_chaining.h"
+#include "hashtable_small.h"
+#include "hashtable_bucketized.h"
+#include "hashtable_inline.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using Clock = std::chrono::steady_clock;
+
+double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Counts the cache misses of whatever runs between start and stop with the CPU's own counter.
+// Only Linux's perf events are supported, and a VM without a PMU doesn't get one either, so
+// check available() before trusting the count.
+class CacheMissCounter {
+public:
+    CacheMissCounter() {
+#ifdef __linux__
+        perf_event_attr attr{};
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd = int(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+    }
+
+    ~CacheMissCounter() {
+#ifdef __linux__
+        if (fd >= 0) {
+            close(fd);
+        }
+#endif
+    }
+
+    CacheMissCounter(const CacheMissCounter &) = delete;
+    CacheMissCounter &operator=(const CacheMissCounter &) = delete;
+
+    bool available() const {
+        return fd >= 0;
+    }
+
+    void start() {
+#ifdef __linux__
+        if (fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    uint64_t stop() {
+        uint64_t misses = 0;
+#ifdef __linux__
+        if (fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            if (read(fd, &misses, sizeof(misses)) != sizeof(misses)) {
+                misses = 0;
+            }
+        }
+#endif
+        return misses;
+    }
+
+private:
+    int fd = -1;
+};
+
+// A URL key that counts how often it gets compared and hashed
+struct Url {
+    std::string text;
+    static size_t comparisons;
+
+    bool operator==(const Url &rhs) const {
+        comparisons += 1;
+        return text == rhs.text;
+    }
+};
+size_t Url::comparisons = 0;
+
+std::ostream &operator<<(std::ostream &os, const Url &url) {
+    return os << url.text;
+}
+
+struct UrlHash {
+    static size_t calls;
+
+    size_t operator()(const Url &url) const noexcept {
+        calls += 1;
+        return std::hash<std::string>{}(url.text);
+    }
+};
+size_t UrlHash::calls = 0;
+
+// 100 byte URLs that share a long common prefix, like the ones in our request logs
+std::vector<Url> makeUrls(size_t count, std::mt19937_64 &rng) {
+    std::vector<Url> urls(count);
+    for (Url &url : urls) {
+        url.text = "https://static.example.com/assets/v2/images/thumbnails/";
+        while (url.text.size() < 100) {
+            url.text += char('a' + rng() % 26);
+        }
+    }
+    return urls;
+}
+
+// Grow a default table to count URL keys, then look half of them up and miss on the other half
+void urlWorkload(size_t count) {
+    std::mt19937_64 rng(221);
+    std::vector<Url> urls = makeUrls(count, rng);
+    std::vector<Url> misses = makeUrls(count, rng);
+
+    HashTable<Url, UrlHash> table;
+    Url::comparisons = 0;
+    UrlHash::calls = 0;
+    Clock::time_point start = Clock::now();
+    for (const Url &url : urls) {
+        table.insert(url);
+    }
+    double growTime = secondsSince(start);
+    std::cout << "url insert: " << growTime * 1e9 / double(count) << " ns/op, "
+              << table.bucket_count() << " buckets, " << UrlHash::calls << " hash calls, "
+              << double(Url::comparisons) / double(count) << " compares/op" << std::endl;
+
+    Url::comparisons = 0;
+    size_t found = 0;
+    start = Clock::now();
+    for (size_t i = 0; i < count; i++) {
+        found += table.contains(i % 2 == 0 ? urls[i] : misses[i]);
+    }
+    double lookupTime = secondsSince(start);
+    std::cout << "url contains: " << lookupTime * 1e9 / double(count) << " ns/op, "
+              << found << " hits, " << double(Url::comparisons) / double(count) << " compares/op" << std::endl;
+}
+
+// An attacker who knows the hash function can send keys that all land in one bucket
+struct CollidingHash {
+    size_t operator()(int) const noexcept {
+        return 42;
+    }
+};
+
+// Every key collides, so without tree bins each operation would walk the whole chain
+void collisionWorkload(size_t count) {
+    HashTable<int, CollidingHash> table;
+
+    Clock::time_point start = Clock::now();
+    for (size_t i = 0; i < count; i++) {
+        table.insert(int(i * 7919));
+    }
+    double insertTime = secondsSince(start);
+
+    size_t found = 0;
+    start = Clock::now();
+    for (size_t i = 0; i < count; i++) {
+        found += table.contains(int(i * 7919 + (i % 2)));
+    }
+    double lookupTime = secondsSince(start);
+
+    start = Clock::now();
+    for (size_t i = 0; i < count; i += 2) {
+        table.remove(int(i * 7919));
+    }
+    double removeTime = secondsSince(start);
+
+    std::cout << "colliding keys (" << count << "): insert " << insertTime * 1e9 / double(count)
+              << " ns/op, contains " << lookupTime * 1e9 / double(count) << " ns/op (" << found
+              << " hits), remove " << removeTime * 1e9 / double(count / 2) << " ns/op" << std::endl;
+}
+
+// The inverse of mixHash. Each xorshift by 33 undoes itself, and each multiply is undone by the
+// multiplier's inverse mod 2^64, found with Newton's iteration (each step doubles the correct bits)
+uint64_t unmixHash(uint64_t mixed) {
+    auto inverse = [](uint64_t value) {
+        uint64_t result = value;
+        for (int i = 0; i < 5; i++) {
+            result *= 2 - value * result;
+        }
+        return result;
+    };
+    mixed ^= mixed >> 33;
+    mixed *= inverse(0xc4ceb9fe1a85ec53ULL);
+    mixed ^= mixed >> 33;
+    mixed *= inverse(0xff51afd7ed558ccdULL);
+    mixed ^= mixed >> 33;
+    return mixed;
+}
+
+// std::hash<long long> is the identity and the table's mixHash has no key, so an attacker can run
+// mixHash backwards and pick keys whose mixed hashes are 0, 1, 2, ... Those all scale to bucket 0
+// whatever the table size, and every insert has to walk past all the earlier keys. SeededHash
+// hashes each key with a secret first, so the same keys spread out.
+template<class Hash>
+void adversarialWorkload(const std::string &name, size_t count) {
+
+    std::vector<long long> keys(count);
+    for (size_t i = 0; i < count; i++) {
+        keys[i] = (long long) unmixHash(i);
+    }
+
+    HashTable<long long, Hash> table;
+    Clock::time_point start = Clock::now();
+    for (long long key : keys) {
+        table.insert(key);
+    }
+    double insertTime = secondsSince(start);
+
+    size_t found = 0;
+    start = Clock::now();
+    for (long long key : keys) {
+        found += table.contains(key);
+    }
+    double lookupTime = secondsSince(start);
+
+    std::cout << name << " under attack (" << count << " keys): insert "
+              << double(count) / insertTime / 1e6 << " Mops/s, contains "
+              << double(count) / lookupTime / 1e6 << " Mops/s, " << found << " hits" << std::endl;
+}
+
+// Random keys with lengths drawn uniformly from [minLength, maxLength]
+std::vector<std::string> makeKeys(size_t count, size_t minLength, size_t maxLength, std::mt19937_64 &rng) {
+    std::vector<std::string> keys(count);
+    for (std::string &key : keys) {
+        size_t length = minLength + rng() % (maxLength - minLength + 1);
+        key.resize(length);
+        for (char &c : key) {
+            c = char('a' + rng() % 26);
+        }
+    }
+    return keys;
+}
+
+// Raw hashing speed plus HashTable<std::string> insert cost for one hasher over one key set
+template<class Hash>
+void stringHashWorkload(const std::string &name, const std::vector<std::string> &keys, size_t totalBytes) {
+    Hash hasher;
+    size_t sink = 0;
+    Clock::time_point start = Clock::now();
+    for (int pass = 0; pass < 4; pass++) {
+        for (const std::string &key : keys) {
+            sink += hasher(key);
+        }
+    }
+    double hashTime = secondsSince(start) / 4;
+
+    HashTable<std::string, Hash> table;
+    start = Clock::now();
+    for (const std::string &key : keys) {
+        table.insert(key);
+    }
+    double insertTime = secondsSince(start);
+
+    std::cout << "  " << name << ": hash " << double(totalBytes) / hashTime / 1e9 << " GB/s, insert "
+              << insertTime * 1e9 / double(keys.size()) << " ns/op" << (sink == 1 ? " " : "") << std::endl;
+}
+
+// Compare the string hashers across key length distributions
+void stringHashWorkloads(size_t count) {
+    std::mt19937_64 rng(221);
+    const size_t ranges[][2] = {{8, 16}, {64, 64}, {64, 512}, {512, 512}};
+    for (const auto &range : ranges) {
+        std::vector<std::string> keys = makeKeys(count, range[0], range[1], rng);
+        size_t totalBytes = 0;
+        for (const std::string &key : keys) {
+            totalBytes += key.size();
+        }
+
+        std::cout << "string keys of " << range[0] << "-" << range[1] << " bytes:" << std::endl;
+        stringHashWorkload<std::hash<std::string>>("std::hash", keys, totalBytes);
+        stringHashWorkload<WyHash>("WyHash", keys, totalBytes);
+        stringHashWorkload<StripeHash>("StripeHash", keys, totalBytes);
+        stringHashWorkload<SeededHash<std::string>>("SeededHash", keys, totalBytes);
+    }
+}
+
+// Inserting a range of keys into a default table against one presized with reserve
+void reserveWorkload(size_t count) {
+    std::mt19937_64 rng(221);
+    std::vector<int> keys(count);
+    for (int &key : keys) {
+        key = int(rng() >> 33);
+    }
+
+    HashTable<int> growing;
+    Clock::time_point start = Clock::now();
+    for (int key : keys) {
+        growing.insert(key);
+    }
+    double growingTime = secondsSince(start);
+
+    HashTable<int> reserved;
+    start = Clock::now();
+    reserved.reserve(count);
+    for (int key : keys) {
+        reserved.insert(key);
+    }
+    double reservedTime = secondsSince(start);
+
+    HashTable<int> ranged;
+    start = Clock::now();
+    ranged.insert(keys.begin(), keys.end());
+    double rangeTime = secondsSince(start);
+
+    std::cout << "insert " << count << " keys: growing " << growingTime * 1e9 / double(count) << " ns/key, reserve "
+              << reservedTime * 1e9 / double(count) << " ns/key, range insert " << rangeTime * 1e9 / double(count)
+              << " ns/key" << std::endl;
+}
+
+// Bulk expiry: remove 90% of the keys, then see how big the table is and how long a scan takes
+void expiryWorkload(size_t count) {
+    HashTable<int> table;
+    for (size_t i = 0; i < count; i++) {
+        table.insert(int(i));
+    }
+    size_t peak = table.bucket_count();
+
+    Clock::time_point start = Clock::now();
+    for (size_t i = 0; i < count / 10 * 9; i++) {
+        table.remove(int(i));
+    }
+    double removeTime = secondsSince(start);
+    size_t afterRemove = table.bucket_count();
+
+    table.shrink_to_fit();
+    start = Clock::now();
+    size_t scanned = table.keys().size();
+    double scanTime = secondsSince(start);
+
+    std::cout << "expire 90% of " << count << " keys: remove " << removeTime * 1e9 / double(count / 10 * 9)
+              << " ns/op, size " << peak << " -> " << afterRemove << " -> " << table.bucket_count()
+              << " after shrink_to_fit, scan of " << scanned << " keys " << scanTime * 1e3 << " ms" << std::endl;
+}
+
+// A reused per-request scratch table: a big table gets a handful of keys and is emptied each time.
+// An eager make_empty walks the whole table, so it gets far fewer requests.
+void scratchWorkload(size_t count, bool lazy) {
+    HashTable<int> scratch(expected_size, count);
+    scratch.lazy_clear(lazy);
+    size_t requests = lazy ? 1000000 : 1000;
+
+    Clock::time_point start = Clock::now();
+    for (size_t request = 0; request < requests; request++) {
+        for (int i = 0; i < 8; i++) {
+            scratch.insert(int(request) * 8 + i);
+        }
+        scratch.make_empty();
+    }
+    double time = secondsSince(start);
+
+    std::cout << "scratch table of " << count << " slots, 8 inserts + " << (lazy ? "lazy" : "eager") << " make_empty: "
+              << time * 1e9 / double(requests) << " ns/request" << std::endl;
+}
+
+// Millions of tiny sets: build one with a few keys, look a few keys up, throw it away
+template<class Table>
+void tinySetWorkload(const std::string &name, size_t count) {
+    size_t found = 0;
+    Clock::time_point start = Clock::now();
+    for (size_t set = 0; set < count; set++) {
+        Table table;
+        int keys = int(set % 12) + 1;
+        for (int i = 0; i < keys; i++) {
+            table.insert(int(set) + i * 31);
+        }
+        for (int i = 0; i < 16; i++) {
+            found += table.contains(int(set) + i * 31);
+        }
+    }
+    double time = secondsSince(start);
+    std::cout << name << " tiny sets (" << count << "): " << time * 1e9 / double(count) << " ns/set, "
+              << found << " hits" << std::endl;
+}
+
+// Full scans: copying the keys out against iterating and for_each
+void scanWorkload(size_t count) {
+    HashTable<int> table(expected_size, count);
+    for (size_t i = 0; i < count; i++) {
+        table.insert(int(i * 7));
+    }
+
+    Clock::time_point start = Clock::now();
+    long long keysSum = 0;
+    for (int key : table.keys()) {
+        keysSum += key;
+    }
+    double keysTime = secondsSince(start);
+
+    start = Clock::now();
+    long long iteratorSum = 0;
+    for (int key : table) {
+        iteratorSum += key;
+    }
+    double iteratorTime = secondsSince(start);
+
+    start = Clock::now();
+    long long forEachSum = 0;
+    table.for_each([&forEachSum](int key) {
+        forEachSum += key;
+    });
+    double forEachTime = secondsSince(start);
+
+    std::cout << "scan " << count << " keys: keys() " << keysTime * 1e3 << " ms, iterator " << iteratorTime * 1e3
+              << " ms, for_each " << forEachTime * 1e3 << " ms (sums agree "
+              << (keysSum == iteratorSum && iteratorSum == forEachSum) << ")" << std::endl;
+}
+
+// parallel_for_each and parallel_count_if on pools of 1 to N threads against the single threaded for_each
+void parallelScanWorkload(size_t count) {
+    HashTable<int> table(expected_size, count);
+    for (size_t i = 0; i < count; i++) {
+        table.insert(int(i * 7));
+    }
+
+    Clock::time_point start = Clock::now();
+    size_t serialCount = 0;
+    table.for_each([&serialCount](int key) {
+        serialCount += key % 3 == 0;
+    });
+    std::cout << "for_each count (" << count << "): " << secondsSince(start) * 1e3 << " ms" << std::endl;
+
+    for (unsigned threads = 1; threads <= defaultThreadCount(); threads *= 2) {
+        WorkStealingPool pool(threads);
+        start = Clock::now();
+        std::atomic<long long> sum(0);
+        table.parallel_for_each([&sum](int key) {
+            if (key % 3 == 0) {
+                sum.fetch_add(1, std::memory_order_relaxed);
+            }
+        }, pool);
+        double forEachTime = secondsSince(start);
+
+        start = Clock::now();
+        size_t matches = table.parallel_count_if([](int key) {
+            return key % 3 == 0;
+        }, pool);
+        double countTime = secondsSince(start);
+
+        std::cout << "parallel scan on " << threads << " threads: parallel_for_each " << forEachTime * 1e3
+                  << " ms, parallel_count_if " << countTime * 1e3 << " ms (counts agree "
+                  << (size_t(sum) == serialCount && matches == serialCount) << ")" << std::endl;
+    }
+}
+
+// The set operations against the loops they replace, which walk one table calling contains and
+// insert on another. The small table has a quarter as many keys, so intersect_with and
+// difference_with on the big table get to look up the small table's keys instead of their own.
+void setAlgebraWorkload(size_t count) {
+    HashTable<int> big;
+    HashTable<int> small;
+    for (size_t i = 0; i < count; i++) {
+        big.insert(int(i * 2));
+    }
+    for (size_t i = 0; i < count / 4; i++) {
+        small.insert(int(i * 3));
+    }
+
+    Clock::time_point start = Clock::now();
+    HashTable<int> loopUnion = big;
+    for (int key : small) {
+        loopUnion.insert(key);
+    }
+    double loopUnionTime = secondsSince(start);
+    HashTable<int> loopIntersection;
+    HashTable<int> loopDifference;
+    start = Clock::now();
+    for (int key : big) {
+        if (small.contains(key)) {
+            loopIntersection.insert(key);
+        }
+    }
+    double loopIntersectionTime = secondsSince(start);
+    start = Clock::now();
+    for (int key : big) {
+        if (!small.contains(key)) {
+            loopDifference.insert(key);
+        }
+    }
+    double loopDifferenceTime = secondsSince(start);
+    std::cout << "set operations with loops (" << count << " and " << count / 4 << " keys): union " << loopUnionTime * 1e3
+              << " ms, intersection " << loopIntersectionTime * 1e3 << " ms, difference " << loopDifferenceTime * 1e3 << " ms" << std::endl;
+
+    start = Clock::now();
+    HashTable<int> merged = big;
+    merged.union_with(small);
+    double mergeTime = secondsSince(start);
+    std::cout << "union_with: " << mergeTime * 1e3 << " ms (sizes agree " << (merged.size() == loopUnion.size()) << ")" << std::endl;
+
+    for (unsigned threads = 1; threads <= defaultThreadCount(); threads *= 2) {
+        WorkStealingPool pool(threads);
+        HashTable<int> intersection = big;
+        start = Clock::now();
+        intersection.intersect_with(small, pool);
+        double intersectTime = secondsSince(start);
+
+        HashTable<int> difference = big;
+        start = Clock::now();
+        difference.difference_with(small, pool);
+        double differenceTime = secondsSince(start);
+
+        start = Clock::now();
+        bool subset = intersection.is_subset_of(small, pool);
+        double subsetTime = secondsSince(start);
+
+        std::cout << "on " << threads << " threads: intersect_with " << intersectTime * 1e3 << " ms, difference_with "
+                  << differenceTime * 1e3 << " ms, is_subset_of " << subsetTime * 1e3 << " ms (sizes agree "
+                  << (intersection.size() == loopIntersection.size() && difference.size() == loopDifference.size() && subset) << ")" << std::endl;
+    }
+}
+
+// Moving half of a hot set of URLs into a cold set one key at a time and then the rest all at
+// once, copying with insert, remove and union_with against relinking the nodes with extract and merge
+void migrationWorkload(size_t count) {
+    std::mt19937_64 rng(221);
+    std::vector<Url> urls = makeUrls(count, rng);
+
+    for (bool relink : {false, true}) {
+        HashTable<Url, UrlHash> hot;
+        HashTable<Url, UrlHash> cold;
+        for (const Url &url : urls) {
+            hot.insert(url);
+        }
+
+        UrlHash::calls = 0;
+        Clock::time_point start = Clock::now();
+        for (size_t i = 0; i < count; i += 2) {
+            if (relink) {
+                cold.insert(hot.extract(urls[i]));
+            } else {
+                cold.insert(urls[i]);
+                hot.remove(urls[i]);
+            }
+        }
+        double moveTime = secondsSince(start);
+        size_t moveCalls = UrlHash::calls;
+
+        UrlHash::calls = 0;
+        start = Clock::now();
+        if (relink) {
+            cold.merge(hot);
+        } else {
+            cold.union_with(hot);
+            hot.make_empty();
+        }
+        double mergeTime = secondsSince(start);
+
+        std::cout << (relink ? "extract and merge" : "insert, remove and union_with") << " (" << count << " urls): "
+                  << moveTime * 1e9 / double((count + 1) / 2) << " ns/key moved singly with " << moveCalls << " hash calls, "
+                  << mergeTime * 1e3 << " ms for the rest with " << UrlHash::calls << " hash calls (" << cold.size() << " keys)" << std::endl;
+    }
+}
+
+// The list-of-nodes layout against the bucketized one on the same random int keys, half of the
+// lookups hitting. Besides the time, each gets the CPU's cache misses per lookup where there's a
+// counter to read, and the cache lines a lookup has to read by the layout alone: the bucketized
+// table reports the blocks it reads, and a list lookup reads its bucket's list header plus every
+// node it walks past (all of them on a miss, up to the key's position in the chain on a hit).
+void cacheLayoutWorkload(size_t count) {
+    std::mt19937_64 rng(221);
+    std::vector<int> keys(count);
+    std::vector<int> queries(count);
+    for (size_t i = 0; i < count; i++) {
+        keys[i] = int(rng() >> 34) * 2;
+        queries[i] = i % 2 == 0 ? keys[rng() % (i + 1)] : int(rng() >> 34) * 2 + 1;
+    }
+
+    HashTable<int> lists;
+    BucketizedHashTable<int> blocks;
+    for (int key : keys) {
+        lists.insert(key);
+        blocks.insert(key);
+    }
+
+    // Every key's position in its chain, from iterating since that goes chain by chain
+    double hitNodes = 0;
+    size_t position = 0;
+    size_t previousBucket = SIZE_MAX;
+    for (int key : lists) {
+        size_t n = lists.bucket(key);
+        position = n == previousBucket ? position + 1 : 1;
+        previousBucket = n;
+        hitNodes += double(position);
+    }
+    double missNodes = 0;
+    double blockReads = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (i % 2 == 1) {
+            missNodes += double(lists.bucket_size(lists.bucket(queries[i])));
+        }
+        blockReads += double(blocks.lookup_blocks(queries[i]));
+    }
+    double listLines = 1 + (hitNodes / double(lists.size()) + missNodes / double(count / 2)) / 2;
+
+    CacheMissCounter counter;
+    size_t listHits = 0;
+    counter.start();
+    Clock::time_point start = Clock::now();
+    for (int query : queries) {
+        listHits += lists.contains(query);
+    }
+    double listTime = secondsSince(start);
+    uint64_t listMisses = counter.stop();
+
+    size_t blockHits = 0;
+    counter.start();
+    start = Clock::now();
+    for (int query : queries) {
+        blockHits += blocks.contains(query);
+    }
+    double blockTime = secondsSince(start);
+    uint64_t blockMisses = counter.stop();
+
+    auto missesPerLookup = [&counter, count](uint64_t misses) {
+        return counter.available() ? std::to_string(double(misses) / double(count)) : std::string("n/a");
+    };
+    std::cout << "list buckets (" << count << " int lookups): " << listTime * 1e9 / double(count) << " ns/op, "
+              << missesPerLookup(listMisses) << " cache misses/op, " << listLines << " lines/op by layout" << std::endl;
+    std::cout << "bucketized blocks (" << BucketizedHashTable<int>::slotsPerBlock << " ints per block): " << blockTime * 1e9 / double(count)
+              << " ns/op, " << missesPerLookup(blockMisses) << " cache misses/op, " << blockReads / double(count) << " lines/op by layout, "
+              << blocks.overflow_blocks() << " overflow blocks (hits agree " << (listHits == blockHits) << ")" << std::endl;
+}
+
+// The list-of-nodes layout against the inline-first one on the same keys, timing hits and misses
+// apart. Next to the times goes the number of dependent loads a lookup needs by layout: a list
+// lookup reads its bucket's list header and then walks nodes (up to the key's position in the
+// chain on a hit, all of them on a miss), an inline-first lookup reads its slot and only walks
+// nodes past it.
+template<class Key>
+void inlineFirstWorkload(const std::string &name, std::vector<Key> keys, const std::vector<Key> &misses) {
+    HashTable<Key> lists;
+    InlineHashTable<Key> inlined;
+    for (const Key &key : keys) {
+        lists.insert(key);
+        inlined.insert(key);
+    }
+    std::mt19937_64 rng(221);
+    std::shuffle(keys.begin(), keys.end(), rng);
+
+    // Every key's position in its chain, from iterating since that goes chain by chain
+    double listHitLoads = 0;
+    size_t position = 0;
+    size_t previousBucket = SIZE_MAX;
+    for (const Key &key : lists) {
+        size_t n = lists.bucket(key);
+        position = n == previousBucket ? position + 1 : 1;
+        previousBucket = n;
+        listHitLoads += double(1 + position);
+    }
+    double listMissLoads = 0;
+    double inlineHitLoads = 0;
+    double inlineMissLoads = 0;
+    for (const Key &key : misses) {
+        listMissLoads += double(1 + lists.bucket_size(lists.bucket(key)));
+        inlineMissLoads += double(inlined.lookup_loads(key));
+    }
+    for (const Key &key : keys) {
+        inlineHitLoads += double(inlined.lookup_loads(key));
+    }
+
+    auto timeLookups = [](auto &table, const std::vector<Key> &queries, size_t &found) {
+        Clock::time_point start = Clock::now();
+        for (const Key &query : queries) {
+            found += table.contains(query);
+        }
+        return secondsSince(start) * 1e9 / double(queries.size());
+    };
+    size_t listFound = 0;
+    size_t inlineFound = 0;
+    double listHitTime = timeLookups(lists, keys, listFound);
+    double listMissTime = timeLookups(lists, misses, listFound);
+    double inlineHitTime = timeLookups(inlined, keys, inlineFound);
+    double inlineMissTime = timeLookups(inlined, misses, inlineFound);
+
+    double hits = double(keys.size());
+    double missCount = double(misses.size());
+    std::cout << "list buckets (" << keys.size() << " " << name << " keys): hit " << listHitTime << " ns/op with "
+              << listHitLoads / hits << " loads, miss " << listMissTime << " ns/op with " << listMissLoads / missCount << " loads" << std::endl;
+    std::cout << "inline-first buckets (" << keys.size() << " " << name << " keys): hit " << inlineHitTime << " ns/op with "
+              << inlineHitLoads / hits << " loads, miss " << inlineMissTime << " ns/op with " << inlineMissLoads / missCount << " loads, "
+              << inlined.overflow_nodes() << " keys in overflow nodes (hits agree " << (listFound == inlineFound) << ")" << std::endl;
+}
+
+// Runs the inline-first comparison on int keys and on short string keys
+void inlineFirstWorkloads(size_t count) {
+    std::mt19937_64 rng(221);
+    std::vector<int> intKeys(count);
+    std::vector<int> intMisses(count);
+    for (size_t i = 0; i < count; i++) {
+        intKeys[i] = int(rng() >> 34) * 2;
+        intMisses[i] = int(rng() >> 34) * 2 + 1;
+    }
+    inlineFirstWorkload<int>("int", intKeys, intMisses);
+    inlineFirstWorkload<std::string>("string", makeKeys(count, 8, 24, rng), makeKeys(count, 8, 24, rng));
+}
+
+// Doubling the bucket count of a full table, moving its nodes on pools of 1 to N threads
+void growthWorkload(size_t count) {
+    for (unsigned threads = 1; threads <= defaultThreadCount(); threads *= 2) {
+        HashTable<int> table(expected_size, count);
+        for (size_t i = 0; i < count; i++) {
+            table.insert(int(i * 7));
+        }
+
+        WorkStealingPool pool(threads);
+        size_t before = table.bucket_count();
+        Clock::time_point start = Clock::now();
+        table.rehash(before * 2, pool);
+        double time = secondsSince(start);
+
+        std::cout << "rehash " << count << " keys from " << before << " to " << table.bucket_count() << " buckets on "
+                  << threads << " threads: " << time * 1e3 << " ms (" << time * 1e9 / double(count) << " ns/key)" << std::endl;
+    }
+}
+
+// Building from a range on 1 to N threads against inserting the keys one at a time
+void buildWorkload(size_t count) {
+    std::mt19937_64 rng(221);
+    std::vector<int> keys(count);
+    for (int &key : keys) {
+        key = int(rng() >> 33);
+    }
+
+    HashTable<int> looped;
+    Clock::time_point start = Clock::now();
+    for (int key : keys) {
+        looped.insert(key);
+    }
+    std::cout << "sequential insert (" << count << "): " << secondsSince(start) * 1e9 / double(count) << " ns/key" << std::endl;
+
+    for (unsigned threads = 1; threads <= defaultThreadCount(); threads *= 2) {
+        HashTable<int> built;
+        start = Clock::now();
+        built.build(keys.begin(), keys.end(), threads);
+        std::cout << "build on " << threads << " threads: " << secondsSince(start) * 1e9 / double(count)
+                  << " ns/key (" << built.size() << " keys)" << std::endl;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    size_t count = argc > 1 ? std::stoull(argv[1]) : 1000000;
+
+    urlWorkload(count);
+    collisionWorkload(std::min<size_t>(count, 50000));
+    adversarialWorkload<std::hash<long long>>("std::hash", std::min<size_t>(count, 50000));
+    adversarialWorkload<SeededHash<long long>>("SeededHash", std::min<size_t>(count, 50000));
+    stringHashWorkloads(std::min<size_t>(count, 200000));
+    buildWorkload(count);
+    growthWorkload(count);
+    reserveWorkload(count);
+    expiryWorkload(count);
+    scratchWorkload(count, false);
+    scratchWorkload(count, true);
+    tinySetWorkload<HashTable<int>>("HashTable", count);
+    tinySetWorkload<SmallHashTable<HashTable<int>, 16>>("SmallHashTable", count);
+    scanWorkload(count);
+    parallelScanWorkload(count);
+    setAlgebraWorkload(count);
+    migrationWorkload(count);
+    cacheLayoutWorkload(count);
+    inlineFirstWorkloads(count);
+    return 0;
+}
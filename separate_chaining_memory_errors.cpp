@@ -1,6 +1,27 @@
+#include <cstdlib>
 #include <iostream>
+#include <new>
 #include "hashtable_separate_chaining.h"
 
+// Count every heap allocation, so we can check that tables nobody uses never allocate
+static size_t allocations = 0;
+
+void *operator new(size_t size) {
+    allocations += 1;
+    if (void *memory = std::malloc(size == 0 ? 1 : size)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void *memory, size_t) noexcept {
+    std::free(memory);
+}
+
 int main() {
     std::cout << "make a hash table" << std::endl;
     HashTable<int> table;
@@ -50,5 +71,28 @@ int main() {
     table.remove(2);
     table.remove(3);
 
+    std::cout << "construct, copy, search and destroy empty tables" << std::endl;
+    size_t before = allocations;
+    {
+        HashTable<int> unused;
+        HashTable<int> copy = unused;
+        copy = unused;
+        unused.contains(5);
+        unused.remove(5);
+        unused.make_empty();
+    }
+    if (allocations != before) {
+        std::cout << "empty tables made " << allocations - before << " allocations" << std::endl;
+        return 1;
+    }
+    std::cout << "first insert allocates" << std::endl;
+    {
+        HashTable<int> used;
+        used.insert(1);
+        if (allocations == before || !used.contains(1)) {
+            return 1;
+        }
+    }
+
     return 0;
 }